@@ -1,7 +1,21 @@
 #include "pch.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <optional>
+#include <random>
+#include <sstream>
+#include <thread>
 
+#include "../tictactoe/batch.h"
+#include "../tictactoe/evaluator.h"
+#include "../tictactoe/persistent.h"
+#include "../tictactoe/players.h"
+#include "../tictactoe/ponder.h"
+#include "../tictactoe/spectator.h"
+#include "../tictactoe/threadpool.h"
+#include "../tictactoe/tournament.h"
 #include "../tictactoe/tictactoe.h"
 #include "../tictactoe/userio.h"
 
@@ -175,6 +189,657 @@ TEST(MoveListTests, undo_dont_undo_too_far)
 	EXPECT_EQ(0, moveList.getTurn());
 }
 
+TEST(MoveListTests, bigBoards_widerCells_winsAndUndo)
+{
+	// 2 and 4 bytes per cell
+	for (const RuleSet& ruleSet : { RuleSet(20, 20, 5), RuleSet(256, 256, 5) })
+	{
+		MoveList moveList(ruleSet);
+		for (uint32_t x = 250; x < 254; x++)
+		{
+			moveList.addMove(Move(x % ruleSet.boardWidth, 0));
+			moveList.addMove(Move(x % ruleSet.boardWidth, 1));
+		}
+		EXPECT_FALSE(moveList.getOverallWin());
+		moveList.addMove(Move(254 % ruleSet.boardWidth, 0));
+		EXPECT_EQ(0, moveList.getOverallWin());
+		EXPECT_EQ(9, moveList.getTurn());
+		moveList.undo();
+		EXPECT_TRUE(moveList.isEmptySquare(Move(254 % ruleSet.boardWidth, 0)));
+		EXPECT_EQ(1, moveList.getXorO(Move(253 % ruleSet.boardWidth, 1)));
+	}
+}
+
+TEST(MoveListTests, isInWinningRun_plainArray_upRightDiagonalAtTheEdge)
+{
+	// O on the up-right diagonal from the bottom-left corner, with X's at the other edges to run off the board
+	const RuleSet ruleSet(4, 4, 4);
+	const int cells[4][4] = {
+		{ 0, -1, -1, 1 },
+		{ 0, -1, 1, -1 },
+		{ 0, 1, -1, -1 },
+		{ 1, -1, -1, 0 } };
+	auto xOrOAt = [&cells](Move move) { return cells[move.y][move.x]; };
+	EXPECT_TRUE(isInWinningRun(ruleSet, Move(0, 3), xOrOAt));
+	EXPECT_TRUE(isInWinningRun(ruleSet, Move(2, 1), xOrOAt));
+	EXPECT_FALSE(isInWinningRun(ruleSet, Move(0, 0), xOrOAt));
+	EXPECT_FALSE(isInWinningRun(ruleSet, Move(3, 3), xOrOAt));
+}
+
+TEST(MoveListTests, getBytesPerPosition_oneBytePerCellOnSmallBoards)
+{
+	MoveList small(RuleSet(15, 15, 5));
+	MoveList big(RuleSet(16, 16, 5));
+	EXPECT_EQ(sizeof(MoveList) + 15 * 15, small.getBytesPerPosition());
+	EXPECT_EQ(sizeof(MoveList) + 16 * 16 * 2, big.getBytesPerPosition());
+}
+
+// writes down how big an allocation was asked for and then refuses it, so a test can size a huge board for free
+class RefusingMemoryResource : public pmr::memory_resource
+{
+public:
+	size_t largestRequest = 0;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		largestRequest = max(largestRequest, bytes);
+		throw bad_alloc();
+	}
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override {}
+	bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+TEST(MoveListTests, hugeBoard_cellBytesDontWrapAt4GB)
+{
+	if (sizeof(size_t) < 8)
+		GTEST_SKIP() << "a 32-bit build can't address a board this big";
+	// 2^30 cells at 4 bytes a cell is 2^32 bytes, which comes out as 0 if the sum's done in 32 bits
+	const RuleSet ruleSet(65536, 16384, 5);
+	RefusingMemoryResource refusing;
+	EXPECT_THROW(MoveList(ruleSet, &refusing), bad_alloc);
+	EXPECT_EQ((size_t)1 << 32, refusing.largestRequest);
+}
+
+TEST(MoveListTests, pooledMoveList_copyAndReset_dontTouchGlobalHeap)
+{
+	char buffer[1024];
+	pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+	MoveList moveList(RuleSet(15, 15, 5), &arena);
+	moveList.addMove(Move(7, 7));
+
+	// anything that falls through to the default resource now throws
+	pmr::memory_resource* previousDefault = pmr::set_default_resource(pmr::null_memory_resource());
+	MoveList copy(moveList);
+	copy.addMove(Move(7, 8));
+	moveList.reset();
+	pmr::set_default_resource(previousDefault);
+
+	EXPECT_EQ(0, moveList.getTurn());
+	EXPECT_TRUE(moveList.isEmptySquare(Move(7, 7)));
+	EXPECT_EQ(0, copy.getXorO(Move(7, 7)));
+	EXPECT_EQ(1, copy.getXorO(Move(7, 8)));
+}
+
+TEST(MoveListTests, getMoveForTurn_afterUndo)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.addMove(Move(7, 7));
+	moveList.addMove(Move(14, 3));
+	moveList.addMove(Move(0, 14));
+	moveList.undo();
+	EXPECT_EQ(Move(7, 7), moveList.getMoveForTurn(0));
+	EXPECT_EQ(Move(14, 3), moveList.getMoveForTurn(1));
+	moveList.addMove(Move(1, 2));
+	EXPECT_EQ(Move(1, 2), moveList.getMoveForTurn(2));
+}
+
+static vector<Move> rangeToVector(const CellRange& range)
+{
+	vector<Move> moves;
+	for (Move move : range)
+	{
+		moves.push_back(move);
+	}
+	return moves;
+}
+
+static bool sameCells(vector<Move> a, vector<Move> b)
+{
+	auto byCell = [](Move m1, Move m2) { return make_pair(m1.y, m1.x) < make_pair(m2.y, m2.x); };
+	sort(a.begin(), a.end(), byCell);
+	sort(b.begin(), b.end(), byCell);
+	return a == b;
+}
+
+// what getEmptySquares and getCandidates should hold, worked out the slow way
+static void expectMoveGenerationMatchesBruteForce(const MoveList& moveList, int radius)
+{
+	const RuleSet& ruleSet = moveList.ruleSet;
+	vector<Move> expectedEmpties;
+	vector<Move> expectedCandidates;
+	for (uint32_t y = 0; y < ruleSet.boardHeight; y++)
+	{
+		for (uint32_t x = 0; x < ruleSet.boardWidth; x++)
+		{
+			if (!moveList.isEmptySquare(Move(x, y)))
+				continue;
+			expectedEmpties.push_back(Move(x, y));
+			bool nearStone = false;
+			for (int dy = -radius; dy <= radius; dy++)
+			{
+				for (int dx = -radius; dx <= radius; dx++)
+				{
+					const Move near(x + dx, y + dy);
+					if (ruleSet.isInBounds(near) && !moveList.isEmptySquare(near))
+						nearStone = true;
+				}
+			}
+			if (nearStone)
+				expectedCandidates.push_back(Move(x, y));
+		}
+	}
+	ASSERT_TRUE(sameCells(expectedEmpties, rangeToVector(moveList.getEmptySquares())));
+	ASSERT_TRUE(sameCells(expectedCandidates, rangeToVector(moveList.getCandidates())));
+}
+
+TEST(MoveListTests, moveGeneration_matchesBruteForce)
+{
+	const int radius = 2;
+	MoveList moveList(RuleSet(13, 11, 5));
+	moveList.addMove(Move(6, 5));
+	moveList.addMove(Move(7, 5));
+	// turned on part way through, so it has to pick up what's already there - and cope with those moves being
+	// undone, which it never saw played
+	moveList.enableCandidates(radius);
+	EXPECT_EQ(Move(6, 5), moveList.getMoveForTurn(0));
+	EXPECT_EQ(Move(7, 5), moveList.getMoveForTurn(1));
+
+	mt19937 random(7);
+	for (int step = 0; step < 400; step++)
+	{
+		const vector<Move> emptySquares = rangeToVector(moveList.getEmptySquares());
+		if (moveList.getTurn() > 0 && (emptySquares.empty() || random() % 3 == 0))
+			moveList.undo();
+		else
+			moveList.addMove(emptySquares[random() % emptySquares.size()]);
+		ASSERT_NO_FATAL_FAILURE(expectMoveGenerationMatchesBruteForce(moveList, radius));
+	}
+	while (moveList.getTurn() > 0)
+	{
+		moveList.undo();
+		ASSERT_NO_FATAL_FAILURE(expectMoveGenerationMatchesBruteForce(moveList, radius));
+	}
+}
+
+TEST(MoveListTests, moveGeneration_undoMovesFromBeforeCandidates)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.addMove(Move(7, 8));
+	moveList.addMove(Move(8, 8));
+	// the cells only this one is next to come first in board order, so they're nowhere near the end of the set
+	moveList.addMove(Move(7, 6));
+	moveList.enableCandidates(1);
+	moveList.undo();
+	expectMoveGenerationMatchesBruteForce(moveList, 1);
+	moveList.undo();
+	moveList.undo();
+	EXPECT_TRUE(moveList.getCandidates().empty());
+}
+
+TEST(MoveListTests, moveGeneration_undoRestoresOrder)
+{
+	MoveList moveList(RuleSet(9, 9, 5));
+	moveList.enableCandidates(1);
+	moveList.addMove(Move(4, 4));
+	moveList.addMove(Move(5, 4));
+	const vector<Move> emptiesBefore = rangeToVector(moveList.getEmptySquares());
+	const vector<Move> candidatesBefore = rangeToVector(moveList.getCandidates());
+
+	moveList.addMove(Move(3, 3));
+	moveList.addMove(Move(8, 0));
+	moveList.undo();
+	moveList.undo();
+	EXPECT_EQ(emptiesBefore, rangeToVector(moveList.getEmptySquares()));
+	EXPECT_EQ(candidatesBefore, rangeToVector(moveList.getCandidates()));
+
+	moveList.reset();
+	EXPECT_EQ(81u, moveList.getEmptySquares().size());
+	EXPECT_TRUE(moveList.getCandidates().empty());
+}
+
+TEST(EvaluatorTests, openTwo_countedForPlayer0)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.enableEvaluation();
+	moveList.addMove(Move(7, 7));
+	moveList.addMove(Move(0, 0));
+	moveList.addMove(Move(8, 7));
+	EXPECT_EQ(1, moveList.getEvaluator()->getRunCount(0, 2, 2));
+	EXPECT_EQ(0, moveList.getEvaluator()->getRunCount(0, 2, 1));
+	EXPECT_EQ(0, moveList.getEvaluator()->getRunCount(1, 2, 2));
+	EXPECT_GT(moveList.getEvaluation(), 0);
+}
+
+TEST(EvaluatorTests, blockedEnds_halfOpenThenDead)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.enableEvaluation();
+	moveList.addMove(Move(0, 3));  // X against the left edge
+	moveList.addMove(Move(3, 3));
+	moveList.addMove(Move(1, 3));
+	EXPECT_EQ(1, moveList.getEvaluator()->getRunCount(0, 2, 1));
+	moveList.addMove(Move(2, 3));  // O closes the other end, and has a half-open two of its own
+	EXPECT_EQ(0, moveList.getEvaluator()->getRunCount(0, 2, 1));
+	EXPECT_EQ(1, moveList.getEvaluator()->getRunCount(1, 2, 1));
+	moveList.undo();
+	EXPECT_EQ(1, moveList.getEvaluator()->getRunCount(0, 2, 1));
+}
+
+TEST(EvaluatorTests, incremental_matchesRecount)
+{
+	// random games with random undos; after every change the incremental counts have to match a full recount
+	for (const RuleSet& ruleSet : { RuleSet(3, 3, 3), RuleSet(9, 7, 4), RuleSet(15, 15, 5) })
+	{
+		mt19937 random(42);
+		MoveList moveList(ruleSet);
+		moveList.enableEvaluation();
+		PatternEvaluator fromScratch(ruleSet, pmr::get_default_resource());
+		for (int step = 0; step < 500; step++)
+		{
+			if (moveList.isBoardFull() || (moveList.getTurn() > 0 && random() % 4 == 0))
+			{
+				moveList.undo();
+			}
+			else
+			{
+				Move move(random() % ruleSet.boardWidth, random() % ruleSet.boardHeight);
+				if (!moveList.isValid(move))
+					continue;
+				moveList.addMove(move);
+			}
+			fromScratch.recount(moveList);
+			ASSERT_EQ(fromScratch.getScore(), moveList.getEvaluation());
+			ASSERT_EQ(fromScratch.getWinner(), moveList.getEvaluator()->getWinner());
+			for (int player = 0; player < 2; player++)
+			{
+				for (int length = 2; length < ruleSet.nInARow; length++)
+				{
+					ASSERT_EQ(fromScratch.getRunCount(player, length, 1), moveList.getEvaluator()->getRunCount(player, length, 1));
+					ASSERT_EQ(fromScratch.getRunCount(player, length, 2), moveList.getEvaluator()->getRunCount(player, length, 2));
+				}
+			}
+		}
+	}
+}
+
+TEST(EvaluatorTests, copy_keepsEvaluator)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.enableEvaluation();
+	moveList.addMove(Move(7, 7));
+	moveList.addMove(Move(0, 0));
+	moveList.addMove(Move(8, 8));
+	MoveList copy(moveList);
+	copy.undo();
+	EXPECT_EQ(1, moveList.getEvaluator()->getRunCount(0, 2, 2));
+	EXPECT_EQ(0, copy.getEvaluator()->getRunCount(0, 2, 2));
+}
+
+TEST(PlayerTests, searchPlayer_takesTheWin)
+{
+	MoveList moveList;
+	moveList.addMove(Move(0, 0));
+	moveList.addMove(Move(0, 1));
+	moveList.addMove(Move(1, 0));
+	moveList.addMove(Move(1, 1));
+	SearchPlayer player(2, 7);
+	EXPECT_EQ(Move(2, 0), player.chooseMove(moveList));
+}
+
+TEST(PlayerTests, searchPlayer_blocks)
+{
+	// X has four in a row on row 7 with the left end already blocked
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.addMove(Move(3, 7));
+	moveList.addMove(Move(2, 7));
+	moveList.addMove(Move(4, 7));
+	moveList.addMove(Move(0, 14));
+	moveList.addMove(Move(5, 7));
+	moveList.addMove(Move(14, 0));
+	moveList.addMove(Move(6, 7));
+	SearchPlayer player(2, 7);
+	EXPECT_EQ(Move(7, 7), player.chooseMove(moveList));
+}
+
+TEST(PlayerTests, ponderer_answersTheReplyPlayed)
+{
+	MoveList moveList;
+	moveList.addMove(Move(0, 0));
+	moveList.addMove(Move(1, 1));
+	Ponderer ponderer(2, 1);
+	ponderer.start(moveList);
+	// 3x3 at depth 2 is no time at all, but give it a generous while before calling it stuck
+	for (int wait = 0; wait < 5000 && ponderer.getRepliesSearched() < 7; wait++)
+	{
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	ASSERT_EQ(7u, ponderer.getRepliesSearched());
+	// X threatens down the left side, so the only answer is to block
+	EXPECT_EQ(optional<Move>(Move(0, 2)), ponderer.stop(Move(0, 1)));
+	EXPECT_EQ(nullopt, ponderer.stop(Move(0, 1)));
+}
+
+TEST(PlayerTests, ponderer_stopsPromptly)
+{
+	MoveList moveList(RuleSet(19, 19, 5));
+	moveList.addMove(Move(9, 9));
+	moveList.addMove(Move(10, 10));
+	// far deeper than it could finish
+	Ponderer ponderer(12, 1);
+	ponderer.start(moveList);
+	this_thread::sleep_for(chrono::milliseconds(20));
+	const auto startTime = chrono::steady_clock::now();
+	// nowhere near the stones, so it can't be the reply being searched
+	EXPECT_EQ(nullopt, ponderer.stop(Move(0, 18)));
+	EXPECT_LT(chrono::steady_clock::now() - startTime, chrono::seconds(1));
+}
+
+TEST(PlayerTests, ponderer_replyInFlight_getsToFinish)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.addMove(Move(7, 7));
+	moveList.addMove(Move(8, 8));
+	// deep enough that the first reply is still being searched when we look
+	Ponderer ponderer(5, 1);
+	ponderer.start(moveList);
+	optional<Move> replyInFlight;
+	for (int wait = 0; wait < 5000 && !replyInFlight; wait++)
+	{
+		this_thread::sleep_for(chrono::milliseconds(1));
+		replyInFlight = ponderer.getReplyInFlight();
+	}
+	ASSERT_TRUE(replyInFlight);
+	EXPECT_EQ(0u, ponderer.getRepliesSearched());
+
+	const optional<Move> answer = ponderer.stop(replyInFlight);
+	ASSERT_TRUE(answer);
+	moveList.addMove(replyInFlight.value());
+	EXPECT_TRUE(moveList.isValid(answer.value()));
+}
+
+TEST(PlayerTests, makePlayerFactory_names)
+{
+	EXPECT_TRUE(makePlayerFactory("random"));
+	EXPECT_TRUE(makePlayerFactory("search3"));
+	EXPECT_FALSE(makePlayerFactory("search"));
+	EXPECT_FALSE(makePlayerFactory("search0"));
+	EXPECT_FALSE(makePlayerFactory("deepblue"));
+}
+
+TEST(ThreadPoolTests, nestedSubmits_allRun)
+{
+	atomic<int> ran = 0;
+	WorkStealingPool pool(4);
+	for (int task = 0; task < 100; task++)
+	{
+		pool.submit([&pool, &ran]
+		{
+			for (int child = 0; child < 10; child++)
+				pool.submit([&ran] { ran++; });
+			ran++;
+		});
+	}
+	pool.wait();
+	EXPECT_EQ(1100, ran);
+}
+
+static TournamentSettings makeTestTournament()
+{
+	TournamentSettings settings;
+	settings.ruleSets = { RuleSet(3, 3, 3), RuleSet(5, 4, 4) };
+	settings.engines = { { "random", makePlayerFactory("random").value() }, { "search2", makePlayerFactory("search2").value() } };
+	settings.openings = { { Move(1, 1) }, { Move(4, 3) } };  // the second doesn't fit 3x3
+	settings.gamesPerOpening = 3;
+	settings.threads = 4;
+	return settings;
+}
+
+TEST(PersistentBoardTests, withMove_leavesOriginalAndSiblingsAlone)
+{
+	const PersistentBoard root = PersistentBoard(RuleSet(19, 19, 5)).withMove(Move(9, 9));
+	vector<PersistentBoard> branches;
+	for (uint32_t x = 0; x < 19; x++)
+	{
+		branches.push_back(root.withMove(Move(x, 0)));
+	}
+
+	EXPECT_EQ(1, root.getTurn());
+	EXPECT_TRUE(root.isEmptySquare(Move(3, 0)));
+	for (uint32_t x = 0; x < 19; x++)
+	{
+		EXPECT_EQ(2, branches[x].getTurn());
+		EXPECT_EQ(0, branches[x].getXorO(Move(9, 9)));
+		EXPECT_EQ(1, branches[x].getXorO(Move(x, 0)));
+		EXPECT_TRUE(branches[x].isEmptySquare(Move((x + 1) % 19, 0)));
+	}
+	EXPECT_TRUE(root.isEmptySquare(Move(3, 0)));
+}
+
+TEST(PersistentBoardTests, winnerAndWithoutLastMove)
+{
+	PersistentBoard board(RuleSet(3, 3, 3));
+	for (Move move : { Move(0, 0), Move(1, 1), Move(0, 1), Move(2, 2), Move(0, 2) })
+	{
+		board = board.withMove(move);
+	}
+	EXPECT_EQ(optional<int>(0), board.getWinner());
+	EXPECT_EQ(optional<Move>(Move(0, 2)), board.getLastMove());
+
+	board = board.withoutLastMove();
+	EXPECT_FALSE(board.getWinner());
+	EXPECT_EQ(4, board.getTurn());
+	EXPECT_TRUE(board.isEmptySquare(Move(0, 2)));
+	EXPECT_EQ(optional<Move>(Move(2, 2)), board.getLastMove());
+}
+
+TEST(PersistentBoardTests, toAndFromMoveList_roundTrip)
+{
+	MoveList moveList(RuleSet(40, 30, 5));
+	mt19937 random(3);
+	while (moveList.getTurn() < 200)
+	{
+		const Move move(random() % 40, random() % 30);
+		if (moveList.isEmptySquare(move))
+			moveList.addMove(move);
+	}
+
+	const PersistentBoard board = PersistentBoard::fromMoveList(moveList);
+	const MoveList roundTrip = board.toMoveList();
+	ASSERT_EQ(moveList.getTurn(), roundTrip.getTurn());
+	for (int turnNumber = 0; turnNumber < moveList.getTurn(); turnNumber++)
+	{
+		EXPECT_EQ(moveList.getMoveForTurn(turnNumber), roundTrip.getMoveForTurn(turnNumber));
+	}
+	EXPECT_EQ(moveList.getOverallWin(), board.getWinner());
+	EXPECT_EQ(renderMoveList(moveList), renderMoveList(roundTrip));
+}
+
+TEST(PersistentBoardTests, longGame_destroysWithoutBlowingTheStack)
+{
+	// 90,000 moves of history, each hanging onto the one before - all let go of at the end of this
+	PersistentBoard board(RuleSet(300, 300, 5));
+	for (uint32_t y = 0; y < 300; y++)
+	{
+		for (uint32_t x = 0; x < 300; x++)
+		{
+			board = board.withMove(Move(x, y));
+		}
+	}
+	EXPECT_TRUE(board.isBoardFull());
+}
+
+TEST(SpectatorTests, publish_thenRead_matchesBoard)
+{
+	MoveList moveList(RuleSet(3, 3, 3));
+	SpectatorFeed feed(moveList.ruleSet);
+	moveList.addMove(Move(0, 0));
+	moveList.addMove(Move(1, 1));
+	moveList.addMove(Move(0, 1));
+	moveList.addMove(Move(2, 2));
+	moveList.addMove(Move(0, 2));
+	feed.publish(moveList);
+	EXPECT_EQ(optional<int>(0), feed.read().winner);
+	moveList.undo();
+	feed.publish(moveList);
+
+	const SpectatorSnapshot snapshot = feed.read();
+	EXPECT_EQ(2u, snapshot.version);
+	EXPECT_EQ(4, snapshot.turn);
+	EXPECT_FALSE(snapshot.winner);
+	EXPECT_EQ(0, snapshot.getXorO(feed.ruleSet, Move(0, 1)));
+	EXPECT_EQ(1, snapshot.getXorO(feed.ruleSet, Move(2, 2)));
+	EXPECT_EQ(-1, snapshot.getXorO(feed.ruleSet, Move(0, 2)));
+}
+
+TEST(SpectatorTests, publishAfterResetAndReplay_dropsStaleWinner)
+{
+	MoveList moveList(RuleSet(3, 3, 3));
+	SpectatorFeed feed(moveList.ruleSet);
+	for (Move move : { Move(0, 0), Move(1, 0), Move(0, 1), Move(1, 1), Move(0, 2) })
+	{
+		moveList.addMove(move);
+	}
+	feed.publish(moveList);
+	ASSERT_EQ(optional<int>(0), feed.read().winner);
+
+	// the same five cells with the colors swapped, and nobody's won - no cell went back to empty in between
+	moveList.reset();
+	for (Move move : { Move(1, 0), Move(0, 0), Move(1, 1), Move(0, 1), Move(0, 2) })
+	{
+		moveList.addMove(move);
+	}
+	feed.publish(moveList);
+	const SpectatorSnapshot snapshot = feed.read();
+	EXPECT_FALSE(snapshot.winner);
+	EXPECT_EQ(1, snapshot.getXorO(feed.ruleSet, Move(0, 0)));
+}
+
+TEST(SpectatorTests, publishNewMovesOnly_matchesBoardThroughUndoAndReplay)
+{
+	MoveList moveList(RuleSet(15, 15, 5));
+	moveList.enableMoveGeneration();
+	SpectatorFeed feed(moveList.ruleSet);
+	auto expectFeedMatchesBoard = [&]()
+	{
+		const SpectatorSnapshot snapshot = feed.read();
+		EXPECT_EQ(moveList.getTurn(), snapshot.turn);
+		EXPECT_EQ(moveList.getOverallWin(), snapshot.winner);
+		for (uint32_t y = 0; y < moveList.ruleSet.boardHeight; y++)
+		{
+			for (uint32_t x = 0; x < moveList.ruleSet.boardWidth; x++)
+			{
+				ASSERT_EQ(moveList.getXorO(Move(x, y)), snapshot.getXorO(feed.ruleSet, Move(x, y))) << x << "," << y;
+			}
+		}
+	};
+
+	// a few moves at a time, the way a spectator might only be updated every so often
+	for (Move move : { Move(3, 7), Move(3, 8), Move(4, 7), Move(4, 8), Move(5, 7), Move(5, 8) })
+	{
+		moveList.addMove(move);
+	}
+	feed.publish(moveList);
+	expectFeedMatchesBoard();
+
+	// an undo and then more moves than it took away, so the turn still goes up between publishes
+	moveList.undo();
+	moveList.undo();
+	for (Move move : { Move(0, 0), Move(0, 1), Move(6, 7), Move(5, 8), Move(5, 7), Move(1, 1), Move(7, 7) })
+	{
+		moveList.addMove(move);
+	}
+	feed.publish(moveList);
+	expectFeedMatchesBoard();
+	EXPECT_TRUE(feed.read().winner);
+
+	moveList.reset();
+	moveList.addMove(Move(7, 7));
+	feed.publish(moveList);
+	expectFeedMatchesBoard();
+}
+
+TEST(SpectatorTests, readersUnderContention_neverSeeHalfAMove)
+{
+	// if a reader ever caught publish part way through, the stones wouldn't add up to the turn
+	const RuleSet ruleSet(7, 7, 4);
+	const int readerCount = 3;
+	SpectatorFeed feed(ruleSet);
+	atomic<int> readersFinished = 0;
+	atomic<int> badReads = 0;
+	vector<thread> readers;
+	for (int reader = 0; reader < readerCount; reader++)
+	{
+		readers.emplace_back([&feed, &readersFinished, &badReads]
+		{
+			SpectatorSnapshot snapshot;
+			uint64_t lastVersion = 0;
+			for (int read = 0; read < 20000; read++)
+			{
+				feed.read(snapshot);
+				const int xs = (int)count(snapshot.cells.begin(), snapshot.cells.end(), (int8_t)0);
+				const int os = (int)count(snapshot.cells.begin(), snapshot.cells.end(), (int8_t)1);
+				if (xs != (snapshot.turn + 1) / 2 || os != snapshot.turn / 2 || snapshot.version < lastVersion)
+					badReads++;
+				lastVersion = snapshot.version;
+			}
+			readersFinished++;
+		});
+	}
+
+	MoveList moveList(ruleSet);
+	RandomPlayer player(5);
+	while (readersFinished < readerCount)
+	{
+		if (moveList.isBoardFull() || moveList.getOverallWin())
+			moveList.reset();
+		else
+			moveList.addMove(player.chooseMove(moveList));
+		feed.publish(moveList);
+	}
+	for (thread& reader : readers)
+	{
+		reader.join();
+	}
+	EXPECT_EQ(0, badReads.load());
+}
+
+TEST(TournamentTests, runTournament_schedulesEveryPairingAndColor)
+{
+	TournamentSettings settings = makeTestTournament();
+	TournamentResult result = runTournament(settings);
+	// (1 opening on 3x3 + 2 on 5x4) * 2 color assignments * 3 games
+	ASSERT_EQ(18u, result.games.size());
+	for (int engine = 0; engine < 2; engine++)
+	{
+		const EngineStats& stats = result.engineStats[engine];
+		EXPECT_EQ(18, stats.wins + stats.draws + stats.losses);
+	}
+	EXPECT_EQ(result.engineStats[0].wins, result.engineStats[1].losses);
+	EXPECT_EQ(Move(1, 1), result.games[0].moves[0]);
+	EXPECT_GT(result.engineStats[1].wins, result.engineStats[0].wins);
+}
+
+TEST(TournamentTests, readOpenings_movesAndComments)
+{
+	istringstream openingsFile("# center openings\n7,7 7,8\n\n7,7\n");
+	auto openings = readOpenings(openingsFile);
+	ASSERT_EQ(2u, openings.value().size());
+	EXPECT_EQ(Move(7, 8), openings.value()[0][1]);
+	istringstream badOpeningsFile("7,7 u\n");
+	EXPECT_FALSE(readOpenings(badOpeningsFile));
+}
+
 TEST(TicTacToeTests, renderMoveList_empty)
 {
 	MoveList moveList;
@@ -233,6 +898,41 @@ public:
 	vector<string> inputStrings;
 };
 
+// plays the first empty square it finds, after a moment's thought
+class FirstEmptySquareHumanMock : public IUserIO
+{
+public:
+	explicit FirstEmptySquareHumanMock(const MoveList& _moveList) : moveList(_moveList) {}
+	void print(const char*) override {}
+	string scan() override
+	{
+		this_thread::sleep_for(chrono::milliseconds(50));
+		for (uint32_t y = 0; y < moveList.ruleSet.boardHeight; y++)
+		{
+			for (uint32_t x = 0; x < moveList.ruleSet.boardWidth; x++)
+			{
+				if (moveList.isEmptySquare(Move(x, y)))
+					return to_string(x) + "," + to_string(y);
+			}
+		}
+		return "";
+	}
+
+private:
+	const MoveList& moveList;
+};
+
+TEST(PlayerTests, playAgainstComputer_pondering_computerNeverLoses)
+{
+	MoveList moveList;
+	auto human = make_shared<FirstEmptySquareHumanMock>(moveList);
+	const ComputerGameStats stats = playAgainstComputer(moveList, human, 9, true);
+	EXPECT_NE(optional<int>(0), moveList.getOverallWin());
+	EXPECT_EQ(moveList.getTurn() / 2, stats.computerMoves);
+	// the human takes 50ms a move, which is forever on 3x3
+	EXPECT_GT(stats.ponderHits, 0);
+}
+
 TEST(TicTacToeTests, takeTurn_CatsGame_noWinner)
 {
 	MoveList moveList;
@@ -354,3 +1054,119 @@ TEST(TicTacToeTests, shallWePlayAGame_fullGameIntegrationTestWithUndoes)
 	EXPECT_EQ("XO \nOX \n  X\n", sharedUserIOMock->outputStrings[20]);
 	EXPECT_EQ("Player 0 wins!\n", sharedUserIOMock->outputStrings[21]);
 }
+
+TEST(TicTacToeTests, shallWePlayAGame_gomokuRules_usesRuleSet)
+{
+	auto sharedUserIOMock = make_shared<UserIOMock>();
+	for (const char* move : { "3,0", "3,1", "2,0", "2,1", "1,0", "1,1", "0,0" })
+		sharedUserIOMock->inputStrings.push_back(move);
+	shallWePlayAGame(sharedUserIOMock, RuleSet(4, 2, 4));
+	EXPECT_EQ("   X\n    \n", sharedUserIOMock->outputStrings[2]);
+	EXPECT_EQ("XXXX\n OOO\n", sharedUserIOMock->outputStrings[14]);
+	EXPECT_EQ("Player 0 wins!\n", sharedUserIOMock->outputStrings[15]);
+}
+
+TEST(BatchTests, parseRuleSet_good_returnsRuleSet)
+{
+	optional<RuleSet> ruleSet = parseRuleSet("15x19x5");
+	EXPECT_EQ(15u, ruleSet.value().boardWidth);
+	EXPECT_EQ(19u, ruleSet.value().boardHeight);
+	EXPECT_EQ(5, ruleSet.value().nInARow);
+}
+
+TEST(BatchTests, parseRuleSet_garbage_returnsnullopt)
+{
+	EXPECT_FALSE(parseRuleSet("3x3"));
+	EXPECT_FALSE(parseRuleSet("3x3x3x"));
+	EXPECT_FALSE(parseRuleSet("0x3x3"));
+	EXPECT_FALSE(parseRuleSet("3x3x0"));
+}
+
+TEST(BatchTests, playScriptedGame_win)
+{
+	ScriptedGameResult result = playScriptedGame(RuleSet(3, 3, 3), "0,0 0,1 1,1 1,0 2,2");
+	EXPECT_EQ(0, result.winner);
+	EXPECT_TRUE(result.isFinished);
+	EXPECT_EQ(5, result.movesPlayed);
+	EXPECT_EQ("Player 0 wins", describeResult(result));
+}
+
+TEST(BatchTests, playScriptedGame_undoThenDraw)
+{
+	ScriptedGameResult result = playScriptedGame(RuleSet(3, 3, 3), " 0,0 2,2 u 0,1 1,0 1,1 2,1 2,0 0,2 1,2 2,2\r");
+	EXPECT_FALSE(result.winner);
+	EXPECT_TRUE(result.isFinished);
+	EXPECT_EQ("Nobody wins", describeResult(result));
+}
+
+TEST(BatchTests, playScriptedGame_occupiedSquare_invalid)
+{
+	ScriptedGameResult result = playScriptedGame(RuleSet(3, 3, 3), "0,0 1,1 0,0");
+	EXPECT_EQ("0,0", result.invalidCommand);
+	EXPECT_EQ(2, result.movesPlayed);
+	EXPECT_EQ("invalid move '0,0' (command 3)", describeResult(result));
+}
+
+TEST(BatchTests, playScriptedGame_moveAfterWin_invalid)
+{
+	ScriptedGameResult result = playScriptedGame(RuleSet(3, 3, 3), "0,0 0,1 1,1 1,0 2,2 2,0");
+	EXPECT_EQ("2,0", result.invalidCommand);
+	EXPECT_EQ(0, result.winner);
+}
+
+TEST(BatchTests, playBatch_onlyPrintsResults)
+{
+	istringstream scripts(
+		"# a comment\n"
+		"0,0 0,1 1,1 1,0 2,2\n"
+		"\n"
+		"0,0 1,1\n"
+		"4,4\n");
+	auto sharedUserIOMock = make_shared<UserIOMock>();
+	BatchSummary summary = playBatch(scripts, RuleSet(3, 3, 3), sharedUserIOMock);
+	EXPECT_EQ(3, summary.games);
+	EXPECT_EQ(7, summary.moves);
+	ASSERT_EQ(4u, sharedUserIOMock->outputStrings.size());
+	EXPECT_EQ("Game 1: Player 0 wins\n", sharedUserIOMock->outputStrings[0]);
+	EXPECT_EQ("Game 2: unfinished\n", sharedUserIOMock->outputStrings[1]);
+	EXPECT_EQ("Game 3: invalid move '4,4' (command 1)\n", sharedUserIOMock->outputStrings[2]);
+	EXPECT_EQ(0u, sharedUserIOMock->outputStrings[3].find("3 games, 7 moves in "));
+}
+
+TEST(BatchTests, playBatch_badRules_gamesInvalidUntilGoodRules)
+{
+	istringstream scripts(
+		"# rules 9x9x5\n"
+		"0,0 0,1 1,0 1,1 2,0 2,1 3,0 3,1 4,0\n"
+		"# rules 0x0x0\n"
+		"0,0 0,1 1,0 1,1 2,0 2,1 3,0 3,1 4,0\n"
+		"# rules 3x3x3\n"
+		"0,0 0,1 1,0 1,1 2,0\n");
+	auto sharedUserIOMock = make_shared<UserIOMock>();
+	BatchSummary summary = playBatch(scripts, RuleSet(), sharedUserIOMock);
+	EXPECT_EQ(3, summary.games);
+	EXPECT_EQ(14, summary.moves);
+	ASSERT_EQ(5u, sharedUserIOMock->outputStrings.size());
+	EXPECT_EQ("Game 1: Player 0 wins\n", sharedUserIOMock->outputStrings[0]);
+	EXPECT_EQ("I don't understand the rules '0x0x0'\n", sharedUserIOMock->outputStrings[1]);
+	EXPECT_EQ("Game 2: invalid rules '0x0x0'\n", sharedUserIOMock->outputStrings[2]);
+	EXPECT_EQ("Game 3: Player 0 wins\n", sharedUserIOMock->outputStrings[3]);
+}
+
+TEST(TournamentTests, writeArchive_replaysInBatch)
+{
+	TournamentSettings settings = makeTestTournament();
+	TournamentResult result = runTournament(settings);
+	stringstream archive;
+	writeArchive(archive, settings, result);
+
+	auto sharedUserIOMock = make_shared<UserIOMock>();
+	BatchSummary summary = playBatch(archive, RuleSet(3, 3, 3), sharedUserIOMock);
+	ASSERT_EQ((int)result.games.size(), summary.games);
+	for (size_t gameIndex = 0; gameIndex < result.games.size(); gameIndex++)
+	{
+		const optional<int>& winner = result.games[gameIndex].winner;
+		const string expected = "Game " + to_string(gameIndex + 1) + ": " + (winner ? "Player " + to_string(winner.value()) + " wins" : "Nobody wins") + "\n";
+		EXPECT_EQ(expected, sharedUserIOMock->outputStrings[gameIndex]);
+	}
+}
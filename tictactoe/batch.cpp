@@ -0,0 +1,147 @@
+#include <assert.h>
+
+#include <chrono>
+#include <istream>
+#include <utility>
+
+#include "batch.h"
+#include "userio.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	optional<RuleSet> parseRuleSet(const string& text)
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		int32_t nInARow = 0;
+		int charsRead = 0;
+		int count = sscanf_s(text.c_str(), "%ux%ux%d%n", &width, &height, &nInARow, &charsRead);
+		if (count != 3 || charsRead != (int)text.size())
+			return nullopt;
+		// the turn # has to fit in an int
+		if (width == 0 || height == 0 || nInARow <= 0 || (uint64_t)width * height > (uint64_t)numeric_limits<int>::max())
+			return nullopt;
+		// and at up to 4 bytes a cell the board has to fit in memory we can address, which on a 32-bit build it may not
+		if ((uint64_t)width * height * sizeof(uint32_t) > (uint64_t)numeric_limits<size_t>::max())
+			return nullopt;
+		return RuleSet(width, height, nInARow);
+	}
+
+	ScriptedGameResult playScriptedGame(const RuleSet& ruleSet, const string& script)
+	{
+		MoveList moveList(ruleSet);
+		return playScriptedGame(moveList, script);
+	}
+
+	ScriptedGameResult playScriptedGame(MoveList& moveList, const string& script)
+	{
+		ScriptedGameResult result;
+		moveList.reset();
+
+		// splitting by hand rather than with a stringstream - this is the hot loop when load-testing
+		const char* whitespace = " \t\r\n";
+		for (size_t tokenBegin = script.find_first_not_of(whitespace); tokenBegin != string::npos;)
+		{
+			const size_t tokenEnd = script.find_first_of(whitespace, tokenBegin);
+			const string command = script.substr(tokenBegin, tokenEnd - tokenBegin);
+			tokenBegin = script.find_first_not_of(whitespace, tokenEnd);
+			result.commandIndex++;
+
+			const optional<Move> input = result.isFinished ? nullopt : moveList.getValidInput(command);
+			if (!input)
+			{
+				result.invalidCommand = command;
+				return result;
+			}
+			if (input == UndoMove)
+			{
+				moveList.undo();
+			}
+			else
+			{
+				moveList.addMove(input.value());
+				result.winner = moveList.getOverallWin();
+				result.isFinished = result.winner || moveList.isBoardFull();
+			}
+			result.movesPlayed = moveList.getTurn();
+		}
+		return result;
+	}
+
+	string describeResult(const ScriptedGameResult& result)
+	{
+		if (result.invalidCommand)
+			return "invalid move '" + result.invalidCommand.value() + "' (command " + to_string(result.commandIndex) + ")";
+		if (result.winner)
+			return "Player " + to_string(result.winner.value()) + " wins";
+		return result.isFinished ? "Nobody wins" : "unfinished";
+	}
+
+	BatchSummary playBatch(istream& scripts, const RuleSet& ruleSet, weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		BatchSummary summary;
+		// optional because a MoveList's rules can't change, so a "# rules" line means building a new one - and
+		// empty after rules we couldn't parse, since playing on under the old ones would give wrong results
+		optional<MoveList> moveList(in_place, ruleSet);
+		string badRules;
+		const auto startTime = chrono::steady_clock::now();
+		string script;
+		while (getline(scripts, script))
+		{
+			const size_t firstChar = script.find_first_not_of(" \t\r");
+			if (firstChar == string::npos)
+				continue;
+			if (script[firstChar] == '#')
+			{
+				const string rulesDirective = "# rules ";
+				if (script.compare(firstChar, rulesDirective.size(), rulesDirective) == 0)
+				{
+					const size_t rulesBegin = firstChar + rulesDirective.size();
+					const string rules = script.substr(rulesBegin, script.find_last_not_of(" \t\r") + 1 - rulesBegin);
+					const optional<RuleSet> newRuleSet = parseRuleSet(rules);
+					if (!newRuleSet)
+					{
+						const string error = "I don't understand the rules '" + rules + "'\n";
+						lockedUserIO->print(error.c_str());
+						moveList.reset();
+						badRules = rules;
+						continue;
+					}
+					moveList.emplace(newRuleSet.value());
+				}
+				continue;
+			}
+
+			summary.games++;
+			string description;
+			if (moveList)
+			{
+				const ScriptedGameResult result = playScriptedGame(moveList.value(), script);
+				summary.moves += result.movesPlayed;
+				description = describeResult(result);
+			}
+			else
+			{
+				description = "invalid rules '" + badRules + "'";
+			}
+			const string resultLine = "Game " + to_string(summary.games) + ": " + description + "\n";
+			lockedUserIO->print(resultLine.c_str());
+		}
+		summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+		char summaryLine[160];
+		snprintf(summaryLine, sizeof(summaryLine), "%d games, %d moves in %.3f s - %.0f games/s, %.0f moves/s\n",
+			summary.games, summary.moves, summary.seconds,
+			summary.seconds > 0.0 ? summary.games / summary.seconds : 0.0,
+			summary.seconds > 0.0 ? summary.moves / summary.seconds : 0.0);
+		lockedUserIO->print(summaryLine);
+		return summary;
+	}
+
+}
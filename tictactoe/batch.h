@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "tictactoe.h"
+
+class IUserIO;
+
+namespace TicTacToe {
+
+	// Headless mode: plays pre-scripted games with no prompts or renders, for load-testing and bulk validation.
+	//
+	// A script is one game per line, using the same commands a human would type at the prompt, separated by
+	// whitespace - for example "1,1 0,0 2,2 u 0,2". Blank lines and lines starting with '#' are skipped, except
+	// "# rules WxHxK", which switches the rules for the games after it (tournament archives use that.) If those
+	// rules don't parse, every game up to the next good "# rules" line comes out as "invalid rules '...'".
+
+	// parses "WxHxK", for example "15x15x5" for gomoku - returns nothing if it couldn't parse or the rules make no sense
+	std::optional<RuleSet> parseRuleSet(const std::string& text);
+
+	struct ScriptedGameResult
+	{
+		std::optional<int> winner;
+		bool isFinished = false;     // somebody won or the board filled up
+		// if the script had a move we couldn't play (garbage, occupied square, or anything after the game ended)
+		// this is the offending command and its position in the script
+		std::optional<std::string> invalidCommand;
+		int commandIndex = 0;
+		int movesPlayed = 0;
+	};
+
+	ScriptedGameResult playScriptedGame(const RuleSet& ruleSet, const std::string& script);
+	// resets moveList first - so playing a whole batch can reuse one board without allocating
+	ScriptedGameResult playScriptedGame(MoveList& moveList, const std::string& script);
+
+	// "Player 0 wins", "Nobody wins", "unfinished" or "invalid move '5,5' (command 3)"
+	std::string describeResult(const ScriptedGameResult& result);
+
+	struct BatchSummary
+	{
+		int games = 0;
+		int moves = 0;
+		double seconds = 0.0;
+	};
+
+	// prints one result line per game to userIO, then the throughput summary
+	BatchSummary playBatch(std::istream& scripts, const RuleSet& ruleSet, std::weak_ptr<IUserIO> userIO);
+
+}
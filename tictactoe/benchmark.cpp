@@ -0,0 +1,346 @@
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "evaluator.h"
+#include "persistent.h"
+#include "players.h"
+#include "ponder.h"
+#include "spectator.h"
+#include "tictactoe.h"
+#include "userio.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	// benchmarks write results here so the optimizer can't decide the work is dead
+	static volatile int benchmarkSink = 0;
+
+	static double secondsSince(chrono::steady_clock::time_point startTime)
+	{
+		return chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+	}
+
+	// fills every other cell along the board so copies aren't copying a trivially empty board
+	static void fillHalfTheBoard(MoveList& moveList)
+	{
+		for (uint32_t y = 0; y < moveList.ruleSet.boardHeight; y++)
+		{
+			for (uint32_t x = (y % 2); x < moveList.ruleSet.boardWidth; x += 2)
+			{
+				moveList.addMove(Move(x, y));
+			}
+		}
+	}
+
+	void benchmarkMemory(weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		lockedUserIO->print("rules      int cells  bytes/position  heap copy ns  pool copy ns\n");
+		for (const RuleSet& ruleSet : { RuleSet(3, 3, 3), RuleSet(15, 15, 5), RuleSet(19, 19, 5), RuleSet(300, 300, 5) })
+		{
+			MoveList moveList(ruleSet);
+			fillHalfTheBoard(moveList);
+
+			// what a position cost when every cell was an int in its own std::vector
+			const size_t area = ruleSet.boardWidth * ruleSet.boardHeight;
+			const size_t intCellBytes = sizeof(RuleSet) + sizeof(int) + sizeof(vector<int>) + area * sizeof(int);
+
+			// keep the total work about the same whatever the board size
+			const int copies = (int)max<size_t>(1000, 20'000'000 / area);
+
+			auto startTime = chrono::steady_clock::now();
+			for (int copy = 0; copy < copies; copy++)
+			{
+				MoveList heapCopy(moveList);
+				benchmarkSink = heapCopy.getTurn();
+			}
+			const double heapSeconds = secondsSince(startTime);
+
+			pmr::unsynchronized_pool_resource pool;
+			startTime = chrono::steady_clock::now();
+			for (int copy = 0; copy < copies; copy++)
+			{
+				MoveList pooledCopy(moveList, &pool);
+				benchmarkSink = pooledCopy.getTurn();
+			}
+			const double poolSeconds = secondsSince(startTime);
+
+			const string rules = to_string(ruleSet.boardWidth) + "x" + to_string(ruleSet.boardHeight) + "x" + to_string(ruleSet.nInARow);
+			char line[160];
+			snprintf(line, sizeof(line), "%-9s  %9zu  %14zu  %12.1f  %12.1f\n",
+				rules.c_str(), intCellBytes, moveList.getBytesPerPosition(),
+				heapSeconds * 1e9 / copies, poolSeconds * 1e9 / copies);
+			lockedUserIO->print(line);
+		}
+	}
+
+	void benchmarkEvaluation(weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		// the same middle-game cluster and the same candidate replies on every board size, so the only thing that
+		// changes is the board around them
+		const int clusterRadius = 4;
+		lockedUserIO->print("rules        incremental ns/node  recount ns/node\n");
+		for (uint32_t size : { 15u, 31u, 63u, 127u, 255u })
+		{
+			MoveList moveList(RuleSet(size, size, 5));
+			moveList.enableEvaluation();
+			const uint32_t center = size / 2;
+			mt19937 random(1234);
+			uniform_int_distribution<int> offset(-clusterRadius, clusterRadius);
+			while (moveList.getTurn() < 30)
+			{
+				const Move move(center + offset(random), center + offset(random));
+				if (moveList.isEmptySquare(move))
+					moveList.addMove(move);
+			}
+			vector<Move> replies;
+			for (uint32_t y = center - clusterRadius; y <= center + clusterRadius; y++)
+			{
+				for (uint32_t x = center - clusterRadius; x <= center + clusterRadius; x++)
+				{
+					if (moveList.isEmptySquare(Move(x, y)))
+						replies.push_back(Move(x, y));
+				}
+			}
+
+			const int passes = 20000;
+			auto startTime = chrono::steady_clock::now();
+			for (int pass = 0; pass < passes; pass++)
+			{
+				for (Move reply : replies)
+				{
+					moveList.addMove(reply);
+					benchmarkSink = (int)moveList.getEvaluation();
+					moveList.undo();
+				}
+			}
+			const double incrementalSeconds = secondsSince(startTime);
+
+			PatternEvaluator fromScratch(moveList.ruleSet, pmr::get_default_resource());
+			const int recounts = (int)max<uint32_t>(10, 2'000'000 / (size * size));
+			startTime = chrono::steady_clock::now();
+			for (int recount = 0; recount < recounts; recount++)
+			{
+				fromScratch.recount(moveList);
+				benchmarkSink = (int)fromScratch.getScore();
+			}
+			const double recountSeconds = secondsSince(startTime);
+
+			const string rules = to_string(size) + "x" + to_string(size) + "x5";
+			char line[160];
+			snprintf(line, sizeof(line), "%-9s  %19.1f  %15.1f\n", rules.c_str(),
+				incrementalSeconds * 1e9 / (passes * replies.size()), recountSeconds * 1e9 / recounts);
+			lockedUserIO->print(line);
+		}
+	}
+
+	void benchmarkSpectator(weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		char line[160];
+		snprintf(line, sizeof(line), "on %u hardware threads\n", thread::hardware_concurrency());
+		lockedUserIO->print(line);
+		// a big board too, since that's where anything that looks at every cell on every publish shows up
+		for (const RuleSet& ruleSet : { RuleSet(19, 19, 5), RuleSet(100, 100, 5) })
+		{
+			// the same game over and over: every cell in a shuffled order, but only the first 100 moves before a
+			// reset so it's mostly a game in progress
+			vector<Move> game;
+			for (uint32_t y = 0; y < ruleSet.boardHeight; y++)
+			{
+				for (uint32_t x = 0; x < ruleSet.boardWidth; x++)
+				{
+					game.push_back(Move(x, y));
+				}
+			}
+			shuffle(game.begin(), game.end(), mt19937(1234));
+			game.erase(game.begin() + 100, game.end());
+
+			snprintf(line, sizeof(line), "%ux%ux%d\n", ruleSet.boardWidth, ruleSet.boardHeight, ruleSet.nInARow);
+			lockedUserIO->print(line);
+			lockedUserIO->print("readers  median publish ns  p99 publish ns  reads/s\n");
+			for (int readerCount : { 0, 1, 2, 4, 8 })
+			{
+				SpectatorFeed feed(ruleSet);
+				atomic<bool> stopping = false;
+				atomic<uint64_t> reads = 0;
+				vector<thread> readers;
+				for (int reader = 0; reader < readerCount; reader++)
+				{
+					readers.emplace_back([&feed, &stopping, &reads]
+					{
+						SpectatorSnapshot snapshot;
+						uint64_t myReads = 0;
+						while (!stopping.load(memory_order_relaxed))
+						{
+							feed.read(snapshot);
+							benchmarkSink = snapshot.turn;
+							myReads++;
+						}
+						reads += myReads;
+					});
+				}
+
+				// the way a game thread with a bot in it would have it, which makes publishing new moves O(1)
+				MoveList moveList(ruleSet);
+				moveList.enableMoveGeneration();
+				// timing each publish on its own, so the median isn't thrown off by the writer getting preempted by
+				// a reader on a machine with fewer cores than threads
+				const int publishes = 200'000;
+				vector<double> publishNanoseconds;
+				publishNanoseconds.reserve(publishes);
+				const auto startTime = chrono::steady_clock::now();
+				for (int publish = 0; publish < publishes; publish++)
+				{
+					if (moveList.getTurn() == (int)game.size())
+						moveList.reset();
+					moveList.addMove(game[moveList.getTurn()]);
+					const auto publishStart = chrono::steady_clock::now();
+					feed.publish(moveList);
+					publishNanoseconds.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - publishStart).count());
+				}
+				const double seconds = secondsSince(startTime);
+				stopping = true;
+				for (thread& reader : readers)
+				{
+					reader.join();
+				}
+
+				sort(publishNanoseconds.begin(), publishNanoseconds.end());
+				snprintf(line, sizeof(line), "%7d  %17.1f  %14.1f  %7.0f\n", readerCount, publishNanoseconds[publishes / 2],
+					publishNanoseconds[publishes * 99 / 100], reads / seconds);
+				lockedUserIO->print(line);
+			}
+		}
+	}
+
+	void benchmarkBranching(weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		lockedUserIO->print("rules      MoveList ns/branch  bytes/branch  Persistent ns/branch  bytes/branch\n");
+		for (const RuleSet& ruleSet : { RuleSet(3, 3, 3), RuleSet(15, 15, 5), RuleSet(19, 19, 5), RuleSet(63, 63, 5), RuleSet(300, 300, 5) })
+		{
+			MoveList moveList(ruleSet);
+			fillHalfTheBoard(moveList);
+			const PersistentBoard persistentBoard = PersistentBoard::fromMoveList(moveList);
+			vector<Move> replies;
+			for (uint32_t y = 0; y < ruleSet.boardHeight && replies.size() < 1000; y++)
+			{
+				for (uint32_t x = 0; x < ruleSet.boardWidth && replies.size() < 1000; x++)
+				{
+					if (moveList.isEmptySquare(Move(x, y)))
+						replies.push_back(Move(x, y));
+				}
+			}
+
+			// every branch kept alive at once, the way a variation tree would
+			const int passes = (int)max<size_t>(1, 2'000'000 / (ruleSet.boardWidth * ruleSet.boardHeight * replies.size()));
+			auto startTime = chrono::steady_clock::now();
+			for (int pass = 0; pass < passes; pass++)
+			{
+				vector<MoveList> branches;
+				branches.reserve(replies.size());
+				for (Move reply : replies)
+				{
+					branches.emplace_back(moveList);
+					branches.back().addMove(reply);
+				}
+				benchmarkSink = branches.back().getTurn();
+			}
+			const double moveListSeconds = secondsSince(startTime);
+
+			const int persistentPasses = passes * 10;
+			startTime = chrono::steady_clock::now();
+			for (int pass = 0; pass < persistentPasses; pass++)
+			{
+				vector<PersistentBoard> branches;
+				branches.reserve(replies.size());
+				for (Move reply : replies)
+				{
+					branches.push_back(persistentBoard.withMove(reply));
+				}
+				benchmarkSink = branches.back().getTurn();
+			}
+			const double persistentSeconds = secondsSince(startTime);
+
+			const string rules = to_string(ruleSet.boardWidth) + "x" + to_string(ruleSet.boardHeight) + "x" + to_string(ruleSet.nInARow);
+			char line[160];
+			snprintf(line, sizeof(line), "%-9s  %18.1f  %12zu  %20.1f  %12zu\n", rules.c_str(),
+				moveListSeconds * 1e9 / (passes * replies.size()), moveList.getBytesPerPosition(),
+				persistentSeconds * 1e9 / (persistentPasses * replies.size()), persistentBoard.getBytesPerMove());
+			lockedUserIO->print(line);
+		}
+	}
+
+	// a "human" for benchmarkPondering: thinks for a while, then plays what a shallow search likes
+	class ThinkingHumanMock : public IUserIO
+	{
+	public:
+		ThinkingHumanMock(const MoveList& _moveList, chrono::milliseconds _thinkingTime, uint32_t seed) :
+			moveList(_moveList), thinkingTime(_thinkingTime), mind(1, seed) {}
+
+		void print(const char*) override {}
+		string scan() override
+		{
+			this_thread::sleep_for(thinkingTime);
+			const Move move = mind.chooseMove(moveList);
+			return to_string(move.x) + "," + to_string(move.y);
+		}
+
+	private:
+		const MoveList& moveList;
+		const chrono::milliseconds thinkingTime;
+		SearchPlayer mind;
+	};
+
+	void benchmarkPondering(weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		const RuleSet ruleSet(15, 15, 5);
+		const int depth = 3;
+		const int games = 4;
+		const chrono::milliseconds thinkingTime(250);
+		char line[160];
+		snprintf(line, sizeof(line), "15x15x5, search%d, human thinks %d ms a move, %d games each\n", depth, (int)thinkingTime.count(), games);
+		lockedUserIO->print(line);
+		lockedUserIO->print("pondering  computer moves  ponder hits  mean response ms\n");
+		for (bool pondering : { false, true })
+		{
+			ComputerGameStats totals;
+			for (int game = 0; game < games; game++)
+			{
+				MoveList moveList(ruleSet);
+				auto human = make_shared<ThinkingHumanMock>(moveList, thinkingTime, 100 + game);
+				const ComputerGameStats stats = playAgainstComputer(moveList, human, depth, pondering, 1 + game);
+				totals.computerMoves += stats.computerMoves;
+				totals.ponderHits += stats.ponderHits;
+				totals.responseSeconds += stats.responseSeconds;
+			}
+			snprintf(line, sizeof(line), "%-9s  %14d  %11d  %16.1f\n", pondering ? "on" : "off", totals.computerMoves, totals.ponderHits,
+				totals.computerMoves ? totals.responseSeconds * 1000.0 / totals.computerMoves : 0.0);
+			lockedUserIO->print(line);
+		}
+	}
+
+}
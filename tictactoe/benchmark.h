@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+
+class IUserIO;
+
+namespace TicTacToe {
+
+	// Benchmarks - run them with tictactoeconsole --bench <name>. Like everything else they print through IUserIO.
+
+	// "memory": bytes per position for a few board sizes, and how long copying a board takes from the global heap
+	// versus a pool
+	void benchmarkMemory(std::weak_ptr<IUserIO> userIO);
+
+	// "evaluation": cost per search node (addMove, getEvaluation, undo) of the incremental evaluator on ever bigger
+	// boards, next to recounting the whole board
+	void benchmarkEvaluation(std::weak_ptr<IUserIO> userIO);
+
+	// "spectator": how long the game thread takes to publish a move to a SpectatorFeed with 0 to 8 threads reading
+	// it as fast as they can, on 19x19 and 100x100
+	void benchmarkSpectator(std::weak_ptr<IUserIO> userIO);
+
+	// "branching": time and memory for a thousand sibling branches off a half-full board, copying a MoveList for
+	// each versus PersistentBoard::withMove
+	void benchmarkBranching(std::weak_ptr<IUserIO> userIO);
+
+	// "pondering": a scripted human that takes its time over every move, against the computer with and without
+	// pondering - how long the computer takes to answer once the human's move is in
+	void benchmarkPondering(std::weak_ptr<IUserIO> userIO);
+
+}
@@ -0,0 +1,166 @@
+#include <assert.h>
+
+#include <algorithm>
+
+#include "evaluator.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	const int OffBoard = -2;
+
+	// A half-open run is worth more than an open run one shorter, so the search would rather lengthen a run than keep
+	// it open. Capped so silly nInARows don't overflow.
+	static int64_t runWeight(int length, int openEnds)
+	{
+		return (int64_t)openEnds << min(3 * (length - 1), 60);
+	}
+
+	static int xOrOAt(const MoveList& moveList, int x, int y)
+	{
+		return (x >= 0 && y >= 0 && moveList.ruleSet.isInBounds(Move(x, y))) ? moveList.getXorO(Move(x, y)) : OffBoard;
+	}
+
+	PatternEvaluator::PatternEvaluator(const RuleSet& ruleSet, pmr::memory_resource* memoryResource) :
+		nInARow(ruleSet.nInARow),
+		runCounts(2 * max(ruleSet.nInARow, 1) * 2, 0, memoryResource) {}
+
+	PatternEvaluator::PatternEvaluator(const PatternEvaluator& other, pmr::memory_resource* memoryResource) :
+		nInARow(other.nInARow),
+		score(other.score),
+		winningRuns{ other.winningRuns[0], other.winningRuns[1] },
+		runCounts(other.runCounts, memoryResource) {}
+
+	size_t PatternEvaluator::runCountIndex(int player, int length, int openEnds) const
+	{
+		assert(player == 0 || player == 1);
+		assert(length >= 0 && length < nInARow);
+		assert(openEnds == 1 || openEnds == 2);
+		return (player * nInARow + length) * 2 + (openEnds - 1);
+	}
+
+	int PatternEvaluator::getRunCount(int player, int length, int openEnds) const
+	{
+		return (length >= 2 && length < nInARow) ? runCounts[runCountIndex(player, length, openEnds)] : 0;
+	}
+
+	optional<int> PatternEvaluator::getWinner() const
+	{
+		// only one player can have won in a real game; if both have, whoever got there first is lost to history
+		if (winningRuns[0] > 0)
+			return 0;
+		if (winningRuns[1] > 0)
+			return 1;
+		return nullopt;
+	}
+
+	size_t PatternEvaluator::getBytes() const
+	{
+		return sizeof(PatternEvaluator) + runCounts.capacity() * sizeof(int);
+	}
+
+	void PatternEvaluator::countRun(int player, int length, int openEnds, int sign)
+	{
+		if (length >= nInARow)
+		{
+			winningRuns[player] += sign;
+			return;
+		}
+		if (length < 2 || openEnds == 0)
+			return;
+		runCounts[runCountIndex(player, length, openEnds)] += sign;
+		score += sign * ((player == 0) ? runWeight(length, openEnds) : -runWeight(length, openEnds));
+	}
+
+	void PatternEvaluator::cellChanged(const MoveList& moveList, Move move, int previousXorO)
+	{
+		const int currentXorO = moveList.getXorO(move);
+		for (const auto& direction : LineDirections)
+		{
+			// take out the runs as they were, put back the runs as they are
+			scoreRunsNear(moveList, move, direction[0], direction[1], previousXorO, -1);
+			scoreRunsNear(moveList, move, direction[0], direction[1], currentXorO, +1);
+		}
+	}
+
+	// Counts (sign +1) or uncounts (sign -1) every run along dx,dy that includes move or either of its neighbours
+	// along that line, reading the board as if move held xOrOAtMove. Those are the only runs a change at move can
+	// affect - the ones it joins, splits, or opens/closes an end of.
+	void PatternEvaluator::scoreRunsNear(const MoveList& moveList, Move move, int dx, int dy, int xOrOAtMove, int sign)
+	{
+		auto cellAt = [&](int x, int y)
+		{
+			return (x == (int)move.x && y == (int)move.y) ? xOrOAtMove : xOrOAt(moveList, x, y);
+		};
+
+		// runs are contiguous, so if two of the three cells are in the same run they're next to each other and
+		// remembering the start of the last run we counted is enough to not count it twice
+		int lastRunStartX = -1;
+		int lastRunStartY = -1;
+		for (int offset = -1; offset <= 1; offset++)
+		{
+			const int x = (int)move.x + offset * dx;
+			const int y = (int)move.y + offset * dy;
+			const int xOrO = cellAt(x, y);
+			if (xOrO < 0)
+				continue;
+
+			int startX = x;
+			int startY = y;
+			while (cellAt(startX - dx, startY - dy) == xOrO)
+			{
+				startX -= dx;
+				startY -= dy;
+			}
+			if (startX == lastRunStartX && startY == lastRunStartY)
+				continue;
+			lastRunStartX = startX;
+			lastRunStartY = startY;
+
+			int length = 1;
+			int endX = startX;
+			int endY = startY;
+			while (cellAt(endX + dx, endY + dy) == xOrO)
+			{
+				endX += dx;
+				endY += dy;
+				length++;
+			}
+			const int openEnds = (cellAt(startX - dx, startY - dy) == -1) + (cellAt(endX + dx, endY + dy) == -1);
+			countRun(xOrO, length, openEnds, sign);
+		}
+	}
+
+	void PatternEvaluator::recount(const MoveList& moveList)
+	{
+		fill(runCounts.begin(), runCounts.end(), 0);
+		score = 0;
+		winningRuns[0] = 0;
+		winningRuns[1] = 0;
+		for (const auto& direction : LineDirections)
+		{
+			const int dx = direction[0];
+			const int dy = direction[1];
+			for (int y = 0; y < (int)moveList.ruleSet.boardHeight; y++)
+			{
+				for (int x = 0; x < (int)moveList.ruleSet.boardWidth; x++)
+				{
+					const int xOrO = xOrOAt(moveList, x, y);
+					// only count each run from its first cell
+					if (xOrO < 0 || xOrOAt(moveList, x - dx, y - dy) == xOrO)
+						continue;
+					int length = 1;
+					while (xOrOAt(moveList, x + length * dx, y + length * dy) == xOrO)
+					{
+						length++;
+					}
+					const int openEnds = (xOrOAt(moveList, x - dx, y - dy) == -1) + (xOrOAt(moveList, x + length * dx, y + length * dy) == -1);
+					countRun(xOrO, length, openEnds, +1);
+				}
+			}
+		}
+	}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+#include "tictactoe.h"
+
+namespace TicTacToe {
+
+	// Static evaluation for depth-limited search on big boards (gomoku and friends) where recounting the whole
+	// board at every leaf would be most of the work.
+	//
+	// Keeps a count, for each player, of the runs of 2 to nInARow - 1 stones along rows, columns and diagonals that
+	// can still grow: open (empty squares at both ends) or half-open (one end blocked by the other player or the edge).
+	// Runs that are blocked at both ends can never win so they don't count, and singletons are everywhere so they
+	// don't tell us much.
+	//
+	// MoveList owns one of these once you call enableEvaluation() and tells it about every cell that changes;
+	// the update only walks the four lines through that cell, so it costs O(nInARow) whatever the board size.
+	class PatternEvaluator
+	{
+	public:
+		PatternEvaluator(const RuleSet& ruleSet, std::pmr::memory_resource* memoryResource);
+		PatternEvaluator(const PatternEvaluator& other, std::pmr::memory_resource* memoryResource);
+
+		// call after the cell at move has changed in moveList; previousXorO is what it held before
+		// (-1 for nothing, 0 for X, 1 for O, same as MoveList::getXorO)
+		void cellChanged(const MoveList& moveList, Move move, int previousXorO);
+
+		// throws away the counts and starts over from the whole board - O(n), for when we start tracking a board
+		// that already has moves on it, and for checking the incremental version in the tests
+		void recount(const MoveList& moveList);
+
+		// positive is good for player 0
+		int64_t getScore() const { return score; }
+
+		// openEnds is 1 for half-open, 2 for open
+		int getRunCount(int player, int length, int openEnds) const;
+
+		// we see every run go by anyway, so this is an O(1) getOverallWin for search
+		std::optional<int> getWinner() const;
+
+		size_t getBytes() const;
+
+	private:
+		void scoreRunsNear(const MoveList& moveList, Move move, int dx, int dy, int xOrOAtMove, int sign);
+		void countRun(int player, int length, int openEnds, int sign);
+		size_t runCountIndex(int player, int length, int openEnds) const;
+
+		const int32_t nInARow;
+		int64_t score = 0;
+		// runs of nInARow or more for each player
+		int winningRuns[2] = { 0, 0 };
+		// indexed by runCountIndex
+		std::pmr::vector<int> runCounts;
+	};
+
+}
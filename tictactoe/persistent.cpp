@@ -0,0 +1,221 @@
+#include <assert.h>
+
+#include <array>
+#include <vector>
+
+#include "persistent.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	struct PersistentBoard::Leaf
+	{
+		Leaf() { cells.fill(-1); }
+		array<int8_t, LeafCells> cells;
+	};
+
+	struct PersistentBoard::Branch
+	{
+		array<shared_ptr<const void>, Fanout> children;
+	};
+
+	struct PersistentBoard::HistoryEntry
+	{
+		HistoryEntry(uint32_t _cellIndex, int8_t _winnerBefore, shared_ptr<HistoryEntry> _previous) :
+			cellIndex(_cellIndex), winnerBefore(_winnerBefore), previous(move(_previous)) {}
+
+		~HistoryEntry()
+		{
+			// let go of the chain one link at a time - left to itself a long game would destroy itself
+			// recursively and blow out the stack
+			shared_ptr<HistoryEntry> next = move(previous);
+			while (next && next.use_count() == 1)
+			{
+				next = move(next->previous);
+			}
+		}
+
+		const uint32_t cellIndex;
+		const int8_t winnerBefore;
+		shared_ptr<HistoryEntry> previous;
+	};
+
+	static uint32_t getLevels(const RuleSet& ruleSet, uint32_t leafCells, uint32_t fanout)
+	{
+		const size_t area = (size_t)ruleSet.boardWidth * ruleSet.boardHeight;
+		uint32_t levels = 0;
+		for (size_t cellsCovered = leafCells; cellsCovered < area; cellsCovered *= fanout)
+		{
+			levels++;
+		}
+		return levels;
+	}
+
+	PersistentBoard::PersistentBoard(const RuleSet& _ruleSet) :
+		ruleSet(_ruleSet),
+		levels(getLevels(_ruleSet, LeafCells, Fanout)) {}
+
+	PersistentBoard::PersistentBoard(const RuleSet& _ruleSet, shared_ptr<const void> _root, shared_ptr<HistoryEntry> _history, int _turn, int8_t _winner) :
+		ruleSet(_ruleSet),
+		levels(getLevels(_ruleSet, LeafCells, Fanout)),
+		root(move(_root)),
+		history(move(_history)),
+		turn(_turn),
+		winner(_winner) {}
+
+	PersistentBoard PersistentBoard::fromMoveList(const MoveList& moveList)
+	{
+		PersistentBoard board(moveList.ruleSet);
+		board.root = build(moveList, board.levels, 0);
+
+		// the order the moves went in - getMoveForTurn is O(n) a turn unless the MoveList is generating moves,
+		// so on a big board it's cheaper to turn that on in a scratch copy than to ask it turn by turn
+		optional<MoveList> generatingMoves;
+		const MoveList* orderedMoveList = &moveList;
+		if (moveList.getTurn() > 0)
+		{
+			generatingMoves.emplace(moveList);
+			generatingMoves->enableMoveGeneration();
+			orderedMoveList = &generatingMoves.value();
+		}
+		for (int turnNumber = 0; turnNumber < moveList.getTurn(); turnNumber++)
+		{
+			const Move move = orderedMoveList->getMoveForTurn(turnNumber);
+			// nobody can have won before the last move - playing on past a win isn't a thing
+			board.history = make_shared<HistoryEntry>(move.y * moveList.ruleSet.boardWidth + move.x, (int8_t)-1, board.history);
+		}
+		board.turn = moveList.getTurn();
+		const optional<int> moveListWinner = moveList.getOverallWin();
+		board.winner = moveListWinner ? (int8_t)moveListWinner.value() : (int8_t)-1;
+		return board;
+	}
+
+	shared_ptr<const void> PersistentBoard::build(const MoveList& moveList, uint32_t level, uint32_t firstCell)
+	{
+		const uint32_t area = moveList.ruleSet.boardWidth * moveList.ruleSet.boardHeight;
+		if (firstCell >= area)
+			return nullptr;
+
+		if (level == 0)
+		{
+			shared_ptr<Leaf> leaf;
+			for (uint32_t cellIndex = firstCell; cellIndex < min(firstCell + LeafCells, area); cellIndex++)
+			{
+				const int xOrO = moveList.getXorO(Move(cellIndex % moveList.ruleSet.boardWidth, cellIndex / moveList.ruleSet.boardWidth));
+				if (xOrO == -1)
+					continue;
+				if (!leaf)
+					leaf = make_shared<Leaf>();
+				leaf->cells[cellIndex - firstCell] = (int8_t)xOrO;
+			}
+			return leaf;
+		}
+
+		shared_ptr<Branch> branch;
+		const uint32_t childCells = LeafCells << ((level - 1) * FanoutBits);
+		for (uint32_t child = 0; child < Fanout; child++)
+		{
+			shared_ptr<const void> childNode = build(moveList, level - 1, firstCell + child * childCells);
+			if (!childNode)
+				continue;
+			if (!branch)
+				branch = make_shared<Branch>();
+			branch->children[child] = move(childNode);
+		}
+		return branch;
+	}
+
+	MoveList PersistentBoard::toMoveList(pmr::memory_resource* memoryResource) const
+	{
+		vector<uint32_t> cellForTurn(turn);
+		int turnNumber = turn;
+		for (const HistoryEntry* entry = history.get(); entry; entry = entry->previous.get())
+		{
+			cellForTurn[--turnNumber] = entry->cellIndex;
+		}
+		MoveList moveList(ruleSet, memoryResource);
+		for (uint32_t cellIndex : cellForTurn)
+		{
+			moveList.addMove(Move(cellIndex % ruleSet.boardWidth, cellIndex / ruleSet.boardWidth));
+		}
+		return moveList;
+	}
+
+	int8_t PersistentBoard::getCell(uint32_t cellIndex) const
+	{
+		const void* node = root.get();
+		for (uint32_t level = levels; level > 0 && node; level--)
+		{
+			const uint32_t child = (cellIndex / (LeafCells << ((level - 1) * FanoutBits))) % Fanout;
+			node = static_cast<const Branch*>(node)->children[child].get();
+		}
+		return node ? static_cast<const Leaf*>(node)->cells[cellIndex % LeafCells] : (int8_t)-1;
+	}
+
+	shared_ptr<const void> PersistentBoard::withCell(const shared_ptr<const void>& node, uint32_t level, uint32_t cellIndex, int8_t xOrO)
+	{
+		if (level == 0)
+		{
+			shared_ptr<Leaf> leaf = node ? make_shared<Leaf>(*static_cast<const Leaf*>(node.get())) : make_shared<Leaf>();
+			leaf->cells[cellIndex % LeafCells] = xOrO;
+			return leaf;
+		}
+		shared_ptr<Branch> branch = node ? make_shared<Branch>(*static_cast<const Branch*>(node.get())) : make_shared<Branch>();
+		const uint32_t child = (cellIndex / (LeafCells << ((level - 1) * FanoutBits))) % Fanout;
+		branch->children[child] = withCell(branch->children[child], level - 1, cellIndex, xOrO);
+		return branch;
+	}
+
+	PersistentBoard PersistentBoard::withMove(Move move) const
+	{
+		assert(isValid(move));
+		const uint32_t cellIndex = move.y * ruleSet.boardWidth + move.x;
+		PersistentBoard board(ruleSet, withCell(root, levels, cellIndex, (int8_t)whoseTurn()),
+			make_shared<HistoryEntry>(cellIndex, winner, history), turn + 1, winner);
+		if (board.winner == -1 && isInWinningRun(ruleSet, move, [&board](Move cell) { return board.getXorO(cell); }))
+			board.winner = (int8_t)whoseTurn();
+		return board;
+	}
+
+	PersistentBoard PersistentBoard::withoutLastMove() const
+	{
+		assert(history);
+		return PersistentBoard(ruleSet, withCell(root, levels, history->cellIndex, -1), history->previous, turn - 1, history->winnerBefore);
+	}
+
+	int PersistentBoard::getXorO(Move move) const
+	{
+		assert(ruleSet.isInBounds(move));
+		return getCell(move.y * ruleSet.boardWidth + move.x);
+	}
+
+	bool PersistentBoard::isEmptySquare(Move move) const
+	{
+		return getXorO(move) == -1;
+	}
+
+	bool PersistentBoard::isValid(Move move) const
+	{
+		return ruleSet.isInBounds(move) && isEmptySquare(move);
+	}
+
+	optional<Move> PersistentBoard::getLastMove() const
+	{
+		if (!history)
+			return nullopt;
+		return Move(history->cellIndex % ruleSet.boardWidth, history->cellIndex / ruleSet.boardWidth);
+	}
+
+	optional<int> PersistentBoard::getWinner() const
+	{
+		return (winner == -1) ? nullopt : optional<int>(winner);
+	}
+
+	size_t PersistentBoard::getBytesPerMove() const
+	{
+		return levels * sizeof(Branch) + sizeof(Leaf) + sizeof(HistoryEntry);
+	}
+
+}
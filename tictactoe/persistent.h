@@ -0,0 +1,83 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+#include "tictactoe.h"
+
+namespace TicTacToe {
+
+	// An immutable board, for tools that keep lots of sibling positions alive at once (variation trees, parallel
+	// search roots, what-ifs). withMove leaves this board alone and hands back a new one that shares everything
+	// except the O(log n) nodes on the path down to the cell that changed, so a thousand branches off a 19x19
+	// position cost a thousand paths rather than a thousand boards. Copying one is a couple of shared_ptr copies,
+	// and since nothing ever changes after it's built, any number of threads can read the same one.
+	//
+	// Underneath it's a radix tree: leaves of LeafCells cells (row by row, -1/0/1 like getXorO), branches of
+	// Fanout children, and a missing child means "all empty", so an empty board of any size is O(1). This is the
+	// FP-style board I gave up on at the top of tictactoe.cpp, back for the jobs where sharing beats MoveList's
+	// flat array; MoveList is still what you want for playing and searching down a single line.
+	class PersistentBoard
+	{
+	public:
+		// an empty board, O(1)
+		explicit PersistentBoard(const RuleSet& _ruleSet);
+
+		// O(n) both ways
+		static PersistentBoard fromMoveList(const MoveList& moveList);
+		MoveList toMoveList(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()) const;
+
+		// O(log n) - the move has to be valid
+		PersistentBoard withMove(Move move) const;
+		// O(log n) - back to the board before the last move, which has to exist
+		PersistentBoard withoutLastMove() const;
+
+		// O(log n); -1 for nothing, 0 for X, 1 for O
+		int getXorO(Move move) const;
+		bool isEmptySquare(Move move) const;
+		bool isValid(Move move) const;
+
+		int getTurn() const { return turn; }
+		int whoseTurn() const { return turn % 2; }
+		bool isBoardFull() const { return turn == (int)(ruleSet.boardWidth * ruleSet.boardHeight); }
+		std::optional<Move> getLastMove() const;
+		// kept up to date by withMove, which only has to look at the lines through the new stone
+		std::optional<int> getWinner() const;
+
+		// what one withMove allocates: a new node at every level of the tree plus the history entry (allocator
+		// overhead not included)
+		size_t getBytesPerMove() const;
+
+		const RuleSet& getRuleSet() const { return ruleSet; }
+
+	private:
+		static const uint32_t LeafCells = 64;
+		static const uint32_t FanoutBits = 4;
+		static const uint32_t Fanout = 1 << FanoutBits;
+
+		struct Leaf;
+		struct Branch;
+		struct HistoryEntry;
+
+		PersistentBoard(const RuleSet& _ruleSet, std::shared_ptr<const void> _root, std::shared_ptr<HistoryEntry> _history, int _turn, int8_t _winner);
+
+		int8_t getCell(uint32_t cellIndex) const;
+		// a copy of the path down to cellIndex with the cell changed; node is a Branch, or a Leaf at level 0
+		static std::shared_ptr<const void> withCell(const std::shared_ptr<const void>& node, uint32_t level, uint32_t cellIndex, int8_t xOrO);
+		// the subtree covering cells from firstCell, straight from a MoveList
+		static std::shared_ptr<const void> build(const MoveList& moveList, uint32_t level, uint32_t firstCell);
+
+		// not a public const like MoveList's, so that board = board.withMove(...) works
+		RuleSet ruleSet;
+		// how many levels of Branch there are above the leaves - just enough to cover the board
+		uint32_t levels = 0;
+		std::shared_ptr<const void> root;
+		// the moves, newest first
+		std::shared_ptr<HistoryEntry> history;
+		int turn = 0;
+		// -1 for nobody
+		int8_t winner = -1;
+	};
+
+}
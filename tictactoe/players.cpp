@@ -0,0 +1,154 @@
+#include <assert.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "evaluator.h"
+#include "players.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	// bigger than any evaluation; losing sooner is worse than losing later, so the depth left gets added on
+	const int64_t WinScore = numeric_limits<int64_t>::max() / 4;
+
+	static void getEmptySquares(const MoveList& moveList, vector<Move>& emptySquares)
+	{
+		emptySquares.clear();
+		for (uint32_t y = 0; y < moveList.ruleSet.boardHeight; y++)
+		{
+			for (uint32_t x = 0; x < moveList.ruleSet.boardWidth; x++)
+			{
+				if (moveList.isEmptySquare(Move(x, y)))
+					emptySquares.push_back(Move(x, y));
+			}
+		}
+	}
+
+	//
+	// RandomPlayer
+	//
+	Move RandomPlayer::chooseMove(const MoveList& moveList)
+	{
+		vector<Move> emptySquares;
+		getEmptySquares(moveList, emptySquares);
+		assert(!emptySquares.empty());
+		return emptySquares[uniform_int_distribution<size_t>(0, emptySquares.size() - 1)(random)];
+	}
+
+	//
+	// SearchPlayer
+	//
+	SearchPlayer::SearchPlayer(int _depth, uint32_t seed) :
+		depth(max(_depth, 1)),
+		random(seed) {}
+
+	// boards bigger than this only look at moves near the stones already down
+	const uint32_t CandidateArea = 64;
+	const int CandidateRadius = 2;
+
+	bool SearchPlayer::prepareBoard(MoveList& board)
+	{
+		board.enableEvaluation();
+		const bool useCandidates = board.ruleSet.boardWidth * board.ruleSet.boardHeight > CandidateArea;
+		if (useCandidates)
+			board.enableCandidates(CandidateRadius);
+		return useCandidates;
+	}
+
+	Move SearchPlayer::chooseMove(const MoveList& moveList)
+	{
+		MoveList board(moveList, &pool);
+		const bool useCandidates = prepareBoard(board);
+		stopped = false;
+
+		vector<Move> moves;
+		for (Move move : getMoves(board, useCandidates))
+		{
+			moves.push_back(move);
+		}
+		assert(!moves.empty());
+		shuffle(moves.begin(), moves.end(), random);
+
+		Move bestMove = moves[0];
+		int64_t alpha = -WinScore * 2;
+		for (Move move : moves)
+		{
+			board.addMove(move);
+			const int64_t score = -negamax(board, depth - 1, -WinScore * 2, -alpha, useCandidates);
+			board.undo();
+			if (stopped)
+				break;
+			if (score > alpha)
+			{
+				alpha = score;
+				bestMove = move;
+			}
+		}
+		return bestMove;
+	}
+
+	// Candidates can run out while there are still empty squares (an empty board, or everything near the stones
+	// filled up), so then it's all of them. Either way it's safe to addMove/undo while walking what this returns.
+	CellRange SearchPlayer::getMoves(const MoveList& board, bool useCandidates)
+	{
+		if (useCandidates)
+		{
+			const CellRange candidates = board.getCandidates();
+			if (!candidates.empty())
+				return candidates;
+		}
+		return board.getEmptySquares();
+	}
+
+	// scores are from the point of view of whoever's turn it is in board
+	int64_t SearchPlayer::negamax(MoveList& board, int depthLeft, int64_t alpha, int64_t beta, bool useCandidates)
+	{
+		// relaxed is plenty - all we need is to notice eventually, and it's checked at every node
+		if (stop && stop->load(memory_order_relaxed))
+			stopped = true;
+		if (stopped)
+			return 0;
+		if (board.getEvaluator()->getWinner())
+		{
+			// the player who just moved won
+			return -(WinScore + depthLeft);
+		}
+		if (board.isBoardFull())
+			return 0;
+		if (depthLeft == 0)
+			return (board.whoseTurn() == 0) ? board.getEvaluation() : -board.getEvaluation();
+
+		// fail-hard: anything outside alpha..beta gets clamped
+		for (Move move : getMoves(board, useCandidates))
+		{
+			board.addMove(move);
+			const int64_t score = -negamax(board, depthLeft - 1, -beta, -alpha, useCandidates);
+			board.undo();
+			if (stopped)
+				return 0;
+			if (score >= beta)
+				return beta;
+			alpha = max(alpha, score);
+		}
+		return alpha;
+	}
+
+	optional<PlayerFactory> makePlayerFactory(const string& engineName)
+	{
+		if (engineName == "random")
+		{
+			return PlayerFactory([](uint32_t seed) { return make_unique<RandomPlayer>(seed); });
+		}
+		int depth = 0;
+		int charsRead = 0;
+		if (sscanf_s(engineName.c_str(), "search%d%n", &depth, &charsRead) == 1 && charsRead == (int)engineName.size() && depth > 0)
+		{
+			return PlayerFactory([depth](uint32_t seed) { return make_unique<SearchPlayer>(depth, seed); });
+		}
+		return nullopt;
+	}
+
+}
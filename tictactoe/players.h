@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <string>
+
+#include "tictactoe.h"
+
+namespace TicTacToe {
+
+	// A player that picks its own moves - the non-interactive counterpart of IUserIO, for engines playing each
+	// other without anyone typing.
+	class IPlayer
+	{
+	public:
+		virtual ~IPlayer() = default;
+		// it's this player's turn in moveList and the game isn't over; returns a valid move
+		virtual Move chooseMove(const MoveList& moveList) = 0;
+	};
+
+	// picks any empty square
+	class RandomPlayer : public IPlayer
+	{
+	public:
+		explicit RandomPlayer(uint32_t seed) : random(seed) {}
+		Move chooseMove(const MoveList& moveList) override;
+
+	private:
+		std::mt19937 random;
+	};
+
+	// Depth-limited negamax with alpha-beta over the PatternEvaluator. The seed shuffles the move order, which
+	// breaks ties between equally good moves differently so repeated games aren't all identical. On big boards
+	// it only considers squares near the stones (MoveList::enableCandidates).
+	class SearchPlayer : public IPlayer
+	{
+	public:
+		SearchPlayer(int _depth, uint32_t seed);
+		Move chooseMove(const MoveList& moveList) override;
+
+		// Lets another thread cut a search short: once *stop is true the search unwinds within a node or so, and
+		// whatever chooseMove returns is meaningless - wasStopped says whether that happened. nullptr for never.
+		void setStopFlag(const std::atomic<bool>* _stop) { stop = _stop; }
+		bool wasStopped() const { return stopped; }
+
+		// turns on what search needs in board (evaluation, and candidates on big boards); returns whether it's
+		// using candidates, which is what getMoves wants to know
+		static bool prepareBoard(MoveList& board);
+		static CellRange getMoves(const MoveList& board, bool useCandidates);
+
+	private:
+		int64_t negamax(MoveList& board, int depthLeft, int64_t alpha, int64_t beta, bool useCandidates);
+
+		const int depth;
+		std::mt19937 random;
+		const std::atomic<bool>* stop = nullptr;
+		bool stopped = false;
+		// the search's copy of the board comes from here, so after the first move we're not hitting the global heap
+		std::pmr::unsynchronized_pool_resource pool;
+	};
+
+	// what a tournament needs to make a fresh player for each game, possibly on another thread
+	using PlayerFactory = std::function<std::unique_ptr<IPlayer>(uint32_t seed)>;
+
+	// "random", or "search" followed by a depth, like "search2" - returns nothing if it's not one of those
+	std::optional<PlayerFactory> makePlayerFactory(const std::string& engineName);
+
+}
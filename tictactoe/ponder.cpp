@@ -0,0 +1,187 @@
+#include <assert.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "evaluator.h"
+#include "ponder.h"
+#include "userio.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	//
+	// Ponderer
+	//
+	Ponderer::Ponderer(int depth, uint32_t seed) :
+		player(depth, seed)
+	{
+		player.setStopFlag(&stopping);
+	}
+
+	Ponderer::~Ponderer()
+	{
+		stop(nullopt);
+	}
+
+	void Ponderer::start(const MoveList& moveList)
+	{
+		stop(nullopt);
+		board.emplace(moveList);
+		answers.clear();
+		repliesSearched = 0;
+		stopping = false;
+		finishing = false;
+		replyInFlight = nullopt;
+		thread = std::thread(&Ponderer::ponder, this);
+	}
+
+	optional<Move> Ponderer::stop(optional<Move> reply)
+	{
+		if (!thread.joinable())
+			return nullopt;
+		{
+			// If they played the reply we're partway through, that search is the one worth having, so let it
+			// finish and go no further; anything else gets cut short. Under the lock so the ponder thread can't
+			// be starting its next reply while we decide.
+			lock_guard<mutex> lock(replyMutex);
+			if (reply && reply == replyInFlight)
+				finishing = true;
+			else
+				stopping = true;
+		}
+		thread.join();
+
+		optional<Move> answer;
+		for (const auto& [ponderedReply, ponderedAnswer] : answers)
+		{
+			if (reply == ponderedReply)
+				answer = ponderedAnswer;
+		}
+		answers.clear();
+		return answer;
+	}
+
+	optional<Move> Ponderer::getReplyInFlight() const
+	{
+		lock_guard<mutex> lock(replyMutex);
+		return replyInFlight;
+	}
+
+	void Ponderer::ponder()
+	{
+		MoveList& position = board.value();
+		const bool useCandidates = SearchPlayer::prepareBoard(position);
+		const int opponent = position.whoseTurn();
+
+		// likeliest first: how good each reply looks to the opponent before anyone searches anything
+		vector<pair<int64_t, Move>> replies;
+		for (Move reply : SearchPlayer::getMoves(position, useCandidates))
+		{
+			position.addMove(reply);
+			const int64_t evaluation = (opponent == 0) ? position.getEvaluation() : -position.getEvaluation();
+			replies.emplace_back(position.getEvaluator()->getWinner() ? numeric_limits<int64_t>::max() : evaluation, reply);
+			position.undo();
+		}
+		stable_sort(replies.begin(), replies.end(), [](const auto& reply1, const auto& reply2) { return reply1.first > reply2.first; });
+
+		for (const auto& [evaluation, reply] : replies)
+		{
+			position.addMove(reply);
+			// if that ends the game there's nothing for us to answer
+			if (!position.getEvaluator()->getWinner() && !position.isBoardFull())
+			{
+				{
+					lock_guard<mutex> lock(replyMutex);
+					if (stopping || finishing)
+						return;
+					replyInFlight = reply;
+				}
+				const Move answer = player.chooseMove(position);
+				lock_guard<mutex> lock(replyMutex);
+				if (!player.wasStopped())
+				{
+					answers.emplace_back(reply, answer);
+					repliesSearched++;
+				}
+				replyInFlight = nullopt;
+			}
+			position.undo();
+		}
+	}
+
+	//
+	// playAgainstComputer
+	//
+	const int HumanPlayer = 0;
+
+	ComputerGameStats playAgainstComputer(MoveList& moveList, weak_ptr<IUserIO> userIO, int depth, bool pondering, uint32_t seed)
+	{
+		SearchPlayer computer(depth, seed);
+		optional<Ponderer> ponderer;
+		if (pondering)
+			ponderer.emplace(depth, seed + 1);
+
+		ComputerGameStats stats;
+		optional<Move> ponderedAnswer;
+		auto humanMovedTime = chrono::steady_clock::now();
+		for (;;)
+		{
+			if (moveList.whoseTurn() == HumanPlayer)
+			{
+				const int turnBefore = moveList.getTurn();
+				if (ponderer)
+					ponderer->start(moveList);
+				const PlayStatus playStatus = takeTurn(moveList, userIO);
+				humanMovedTime = chrono::steady_clock::now();
+				if (ponderer)
+					ponderedAnswer = ponderer->stop(moveList.getTurn() > turnBefore ? optional(moveList.getMoveForTurn(turnBefore)) : nullopt);
+				if (playStatus == PlayStatus::GameOver)
+					return stats;
+				if (moveList.getTurn() < turnBefore && moveList.getTurn() > 0)
+				{
+					// that took back the computer's move, so take back theirs as well
+					moveList.undo();
+					auto lockedUserIO = userIO.lock();
+					if (lockedUserIO)
+						lockedUserIO->print(renderMoveList(moveList).c_str());
+				}
+			}
+			else
+			{
+				if (ponderedAnswer)
+					stats.ponderHits++;
+				else
+					ponderedAnswer = computer.chooseMove(moveList);
+				const Move move = ponderedAnswer.value();
+				ponderedAnswer = nullopt;
+				stats.computerMoves++;
+				moveList.addMove(move);
+				stats.responseSeconds += chrono::duration<double>(chrono::steady_clock::now() - humanMovedTime).count();
+
+				auto lockedUserIO = userIO.lock();
+				if (!lockedUserIO)
+					return stats;
+				const string computerMove = "Computer plays " + to_string(move.x) + "," + to_string(move.y) + "\n";
+				lockedUserIO->print(computerMove.c_str());
+				lockedUserIO->print(renderMoveList(moveList).c_str());
+				const optional<int> winner = moveList.getOverallWin();
+				if (winner)
+				{
+					const string winMessage = "Player " + to_string(winner.value()) + " wins!\n";
+					lockedUserIO->print(winMessage.c_str());
+					return stats;
+				}
+				if (moveList.isBoardFull())
+				{
+					lockedUserIO->print("Nobody wins.\n");
+					return stats;
+				}
+			}
+		}
+	}
+
+}
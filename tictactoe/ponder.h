@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "players.h"
+#include "tictactoe.h"
+
+class IUserIO;
+
+namespace TicTacToe {
+
+	// Thinking on the opponent's time. While a human sits on their move, a background thread goes through their
+	// likeliest replies (best static evaluation for them first) and searches our answer to each one. When they
+	// move, stop() cuts the search short and hands back the answer to the reply they actually played, if it got
+	// that far; everything else gets thrown away.
+	class Ponderer
+	{
+	public:
+		// searches the same way a SearchPlayer of this depth would
+		Ponderer(int depth, uint32_t seed);
+		~Ponderer();
+
+		// it's the opponent's turn in moveList; returns straight away
+		void start(const MoveList& moveList);
+		// The opponent played reply (or nothing, if they undid or typed something we couldn't use). Returns our
+		// answer if we'd searched it. If we were searching it right then, that search gets to finish; otherwise
+		// this stops promptly.
+		std::optional<Move> stop(std::optional<Move> reply);
+
+		// how many replies we've got answers for since the last start() - fine to ask while it's running
+		size_t getRepliesSearched() const { return repliesSearched; }
+		// the reply being searched right now, if any - also fine to ask while it's running
+		std::optional<Move> getReplyInFlight() const;
+
+	private:
+		void ponder();
+
+		SearchPlayer player;
+		// cuts the search short, right down in SearchPlayer
+		std::atomic<bool> stopping = false;
+		// lets the reply in flight finish, but starts no more
+		bool finishing = false;
+		// guards replyInFlight and finishing, and the ponder thread moving on to its next reply
+		mutable std::mutex replyMutex;
+		std::optional<Move> replyInFlight;
+		std::thread thread;
+		// the ponder thread's own copy of the position
+		std::optional<MoveList> board;
+		// each reply we finished and our answer to it; only the ponder thread touches it until stop() joins it
+		std::vector<std::pair<Move, Move>> answers;
+		std::atomic<size_t> repliesSearched = 0;
+	};
+
+	struct ComputerGameStats
+	{
+		int computerMoves = 0;
+		// how many of those were answered straight out of the Ponderer
+		int ponderHits = 0;
+		// from the human's move coming in to the computer's move going down, summed over the game
+		double responseSeconds = 0.0;
+	};
+
+	// The human (player 0, through userIO, with takeTurn doing the talking) against a SearchPlayer of the given
+	// depth, optionally pondering while the human thinks. Undo takes back the computer's move too, so it's the
+	// human's turn again.
+	ComputerGameStats playAgainstComputer(MoveList& moveList, std::weak_ptr<IUserIO> userIO, int depth, bool pondering, uint32_t seed = 1);
+
+}
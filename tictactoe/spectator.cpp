@@ -0,0 +1,147 @@
+#include <assert.h>
+
+#include <thread>
+
+#include "spectator.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	SpectatorFeed::SpectatorFeed(const RuleSet& _ruleSet) :
+		ruleSet(_ruleSet),
+		cells(make_unique<atomic<int8_t>[]>(_ruleSet.boardWidth * _ruleSet.boardHeight)),
+		publishedCells(_ruleSet.boardWidth * _ruleSet.boardHeight, (int8_t)-1)
+	{
+		changedCells.reserve(publishedCells.size());
+		for (size_t cellIndex = 0; cellIndex < publishedCells.size(); cellIndex++)
+		{
+			cells[cellIndex].store(-1, memory_order_relaxed);
+		}
+	}
+
+	void SpectatorFeed::publish(const MoveList& moveList)
+	{
+		assert(moveList.ruleSet.boardWidth == ruleSet.boardWidth && moveList.ruleSet.boardHeight == ruleSet.boardHeight);
+
+		// work out what changed first, so the window where readers have to retry is just the stores
+		changedCells.clear();
+		bool anyStoneRemoved = false;
+		// wins only ever get looked for in what's been published
+		auto publishedXorOAt = [this](Move move) { return (int)publishedCells[(size_t)move.y * ruleSet.boardWidth + move.x]; };
+		auto cellChanged = [&](uint32_t x, uint32_t y, int8_t xOrO)
+		{
+			const size_t cellIndex = (size_t)y * ruleSet.boardWidth + x;
+			// an X turning straight into an O (a reset and a different game since the last publish) takes
+			// a stone away just as much as an undo does
+			if (publishedCells[cellIndex] != -1)
+				anyStoneRemoved = true;
+			publishedCells[cellIndex] = xOrO;
+			changedCells.push_back((uint32_t)cellIndex);
+			// a new win has to go through a new stone, so there's no need for getOverallWin's full sweep
+			if (xOrO != -1 && publishedWinner == -1 && isInWinningRun(ruleSet, Move(x, y), publishedXorOAt))
+			{
+				publishedWinner = xOrO;
+			}
+		};
+
+		// The usual case is just more moves on the same game, and then only the new turns can have changed - O(1)
+		// each once move generation's on, and one scan for the one new move if it isn't. Anything else (an undo,
+		// a reset, a different MoveList, several moves with no move generation) means comparing every cell.
+		const bool onlyNewMoves = &moveList == publishedMoveList && moveList.getTakebacks() == publishedTakebacks &&
+			(moveList.isMoveGenerationEnabled() || moveList.getTurn() <= publishedTurn + 1);
+		if (onlyNewMoves)
+		{
+			for (int turnNumber = publishedTurn; turnNumber < moveList.getTurn(); turnNumber++)
+			{
+				const Move move = moveList.getMoveForTurn(turnNumber);
+				cellChanged(move.x, move.y, (int8_t)(turnNumber % 2));
+			}
+		}
+		else
+		{
+			size_t cellIndex = 0;
+			for (uint32_t y = 0; y < ruleSet.boardHeight; y++)
+			{
+				for (uint32_t x = 0; x < ruleSet.boardWidth; x++, cellIndex++)
+				{
+					const int8_t xOrO = (int8_t)moveList.getXorO(Move(x, y));
+					if (xOrO != publishedCells[cellIndex])
+						cellChanged(x, y, xOrO);
+				}
+			}
+		}
+		publishedMoveList = &moveList;
+		publishedTakebacks = moveList.getTakebacks();
+		publishedTurn = moveList.getTurn();
+
+		// taking stones away can take a win away, which is rare enough to just look everywhere
+		if (anyStoneRemoved)
+		{
+			publishedWinner = -1;
+			for (size_t cellIndex = 0; cellIndex < publishedCells.size() && publishedWinner == -1; cellIndex++)
+			{
+				if (publishedCells[cellIndex] != -1 &&
+					isInWinningRun(ruleSet, Move((uint32_t)(cellIndex % ruleSet.boardWidth), (uint32_t)(cellIndex / ruleSet.boardWidth)), publishedXorOAt))
+				{
+					publishedWinner = publishedCells[cellIndex];
+				}
+			}
+		}
+
+		// The release fence keeps the stores below from being seen before the odd sequence number; the release
+		// store at the end keeps them from being seen after the even one. Everything in between can be relaxed.
+		const uint64_t startSequence = sequence.load(memory_order_relaxed);
+		sequence.store(startSequence + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+
+		for (uint32_t changedCell : changedCells)
+		{
+			cells[changedCell].store(publishedCells[changedCell], memory_order_relaxed);
+		}
+		turn.store(moveList.getTurn(), memory_order_relaxed);
+		winner.store(publishedWinner, memory_order_relaxed);
+
+		sequence.store(startSequence + 2, memory_order_release);
+	}
+
+	void SpectatorFeed::read(SpectatorSnapshot& snapshot) const
+	{
+		snapshot.cells.resize(ruleSet.boardWidth * ruleSet.boardHeight);
+		for (;;)
+		{
+			const uint64_t startSequence = sequence.load(memory_order_acquire);
+			if (startSequence % 2 == 1)
+			{
+				// mid-publish; if the game thread got preempted there, spinning would only keep it off the core
+				this_thread::yield();
+				continue;
+			}
+
+			for (size_t cellIndex = 0; cellIndex < snapshot.cells.size(); cellIndex++)
+			{
+				snapshot.cells[cellIndex] = cells[cellIndex].load(memory_order_relaxed);
+			}
+			snapshot.turn = turn.load(memory_order_relaxed);
+			const int8_t snapshotWinner = winner.load(memory_order_relaxed);
+
+			// the acquire fence keeps the loads above from drifting past the second look at the sequence number
+			atomic_thread_fence(memory_order_acquire);
+			if (sequence.load(memory_order_relaxed) == startSequence)
+			{
+				snapshot.winner = (snapshotWinner == -1) ? nullopt : optional<int>(snapshotWinner);
+				snapshot.version = startSequence / 2;
+				return;
+			}
+		}
+	}
+
+	SpectatorSnapshot SpectatorFeed::read() const
+	{
+		SpectatorSnapshot snapshot;
+		read(snapshot);
+		return snapshot;
+	}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "tictactoe.h"
+
+namespace TicTacToe {
+
+	// A copy of a live game as a spectator saw it. Cells are row by row, -1 for empty, 0 for X, 1 for O.
+	struct SpectatorSnapshot
+	{
+		std::vector<int8_t> cells;
+		int turn = 0;
+		std::optional<int> winner;
+		// how many times the game had been published when this was taken
+		uint64_t version = 0;
+
+		int getXorO(const RuleSet& ruleSet, Move move) const { return cells[move.y * ruleSet.boardWidth + move.x]; }
+	};
+
+	// Lets any number of threads (spectators, replay streamers, stats collectors) watch a game while the thread
+	// playing it keeps going. It's a seqlock: the game thread bumps a sequence number to odd, writes the cells that
+	// changed, and bumps it back to even; readers copy everything and try again if the number was odd or moved
+	// while they were copying. Readers never write anything shared, so however many of them there are the game
+	// thread never waits on them - the worst they can do is make it take a few cache misses.
+	//
+	// One thread publishes, and it should be the one that owns the MoveList.
+	class SpectatorFeed
+	{
+	public:
+		explicit SpectatorFeed(const RuleSet& _ruleSet);
+
+		// After addMove/undo/reset - the cells that changed since last time get written, plus the turn and the
+		// winner, which only gets looked for through the stones that are new. Publishing moves added since last
+		// time costs O(1) a move if moveList has move generation on; undo and reset cost a pass over the board.
+		void publish(const MoveList& moveList);
+
+		// From any thread. Reuses snapshot's storage, so a spectator polling in a loop doesn't allocate.
+		void read(SpectatorSnapshot& snapshot) const;
+		SpectatorSnapshot read() const;
+
+		const RuleSet ruleSet;
+
+	private:
+		// even when the data's consistent, odd while publish is writing it
+		std::atomic<uint64_t> sequence = 0;
+		std::unique_ptr<std::atomic<int8_t>[]> cells;
+		std::atomic<int32_t> turn = 0;
+		// -1 for nobody (yet)
+		std::atomic<int8_t> winner = -1;
+
+		// the game thread's own copy of what's in cells, so publish only touches what changed
+		std::vector<int8_t> publishedCells;
+		int8_t publishedWinner = -1;
+		// where the last publish left off, so the next one can tell if it's only got new moves to look at;
+		// the MoveList is only ever compared, never looked at
+		const MoveList* publishedMoveList = nullptr;
+		uint32_t publishedTakebacks = 0;
+		int publishedTurn = 0;
+		// scratch for publish, kept to save allocating
+		std::vector<uint32_t> changedCells;
+	};
+
+}
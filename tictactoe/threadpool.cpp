@@ -0,0 +1,118 @@
+#include <assert.h>
+
+#include <algorithm>
+
+#include "threadpool.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	// so a task submitting more work puts it on its own worker's deque
+	static thread_local const WorkStealingPool* currentPool = nullptr;
+	static thread_local unsigned currentWorkerIndex = 0;
+
+	WorkStealingPool::WorkStealingPool(unsigned threadCount)
+	{
+		// hardware_concurrency is allowed to say 0 if it doesn't know
+		threadCount = max(threadCount, 1u);
+		for (unsigned workerIndex = 0; workerIndex < threadCount; workerIndex++)
+		{
+			workers.push_back(make_unique<Worker>());
+		}
+		for (unsigned workerIndex = 0; workerIndex < threadCount; workerIndex++)
+		{
+			threads.emplace_back(&WorkStealingPool::run, this, workerIndex);
+		}
+	}
+
+	WorkStealingPool::~WorkStealingPool()
+	{
+		wait();
+		{
+			lock_guard<mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		workAvailable.notify_all();
+		for (thread& workerThread : threads)
+		{
+			workerThread.join();
+		}
+	}
+
+	void WorkStealingPool::submit(function<void()> task)
+	{
+		unfinishedTasks++;
+		const unsigned workerIndex = (currentPool == this) ? currentWorkerIndex : (nextWorker++ % workers.size());
+		{
+			lock_guard<mutex> lock(workers[workerIndex]->mutex);
+			workers[workerIndex]->tasks.push_back(move(task));
+		}
+		queuedTasks++;
+		// taking the lock means a worker can't be between checking queuedTasks and going to sleep, so it can't miss this
+		{
+			lock_guard<mutex> lock(sleepMutex);
+		}
+		workAvailable.notify_one();
+	}
+
+	void WorkStealingPool::wait()
+	{
+		// a task waiting for itself to finish would never return
+		assert(currentPool != this);
+		unique_lock<mutex> lock(sleepMutex);
+		allFinished.wait(lock, [this] { return unfinishedTasks == 0; });
+	}
+
+	bool WorkStealingPool::tryTakeTask(unsigned workerIndex, function<void()>& task)
+	{
+		// our own newest first (it's the one most likely to still be in cache), then everybody else's oldest
+		for (unsigned offset = 0; offset < workers.size(); offset++)
+		{
+			Worker& worker = *workers[(workerIndex + offset) % workers.size()];
+			lock_guard<mutex> lock(worker.mutex);
+			if (worker.tasks.empty())
+				continue;
+			if (offset == 0)
+			{
+				task = move(worker.tasks.back());
+				worker.tasks.pop_back();
+			}
+			else
+			{
+				task = move(worker.tasks.front());
+				worker.tasks.pop_front();
+			}
+			queuedTasks--;
+			return true;
+		}
+		return false;
+	}
+
+	void WorkStealingPool::run(unsigned workerIndex)
+	{
+		currentPool = this;
+		currentWorkerIndex = workerIndex;
+		for (;;)
+		{
+			function<void()> task;
+			if (tryTakeTask(workerIndex, task))
+			{
+				task();
+				if (--unfinishedTasks == 0)
+				{
+					lock_guard<mutex> lock(sleepMutex);
+					allFinished.notify_all();
+				}
+				continue;
+			}
+
+			unique_lock<mutex> lock(sleepMutex);
+			workAvailable.wait(lock, [this] { return stopping || queuedTasks > 0; });
+			if (stopping && queuedTasks == 0)
+				return;
+		}
+	}
+
+}
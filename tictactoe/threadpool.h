@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TicTacToe {
+
+	// Every worker has its own deque: it pushes and pops its own work at the back, and when it runs dry it steals
+	// from the front of somebody else's. Tasks submitted from outside get dealt round-robin. Games vary a lot in
+	// length (a 3x3 blowout vs a 19x19 grind) so this keeps all the cores busy without a central queue for them to
+	// fight over.
+	//
+	// A mutex per deque rather than a lock-free Chase-Lev deque - a task here is a whole game, so the locks are
+	// nowhere near the profile.
+	class WorkStealingPool
+	{
+	public:
+		explicit WorkStealingPool(unsigned threadCount = std::thread::hardware_concurrency());
+		// waits for everything submitted to finish
+		~WorkStealingPool();
+
+		void submit(std::function<void()> task);
+		// blocks until every submitted task (including ones submitted by tasks) has run
+		void wait();
+
+		unsigned getThreadCount() const { return (unsigned)workers.size(); }
+
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		void run(unsigned workerIndex);
+		bool tryTakeTask(unsigned workerIndex, std::function<void()>& task);
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::vector<std::thread> threads;
+
+		// submitted but not finished
+		std::atomic<size_t> unfinishedTasks = 0;
+		// sitting in a deque, so worth waking up for
+		std::atomic<size_t> queuedTasks = 0;
+		std::atomic<unsigned> nextWorker = 0;
+		bool stopping = false;
+
+		std::mutex sleepMutex;
+		std::condition_variable workAvailable;
+		std::condition_variable allFinished;
+	};
+
+}
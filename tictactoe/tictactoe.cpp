@@ -3,11 +3,12 @@
 //
 // I know you told me not to overthink this but couldn't help myself. I wanted to show off my automated testing skills,
 // give googletest a whirl (I'm much more familiar with Microsoft's framework but it's not as Switch/PS4 friendly),
-// and experiment with a mostly pure FP approach - which I later abandoned.
+// and experiment with a mostly pure FP approach - which I later abandoned. (Though it came back for keeping lots of
+// branches alive at once - see PersistentBoard in persistent.h.)
 // It's actually been really fun to work on: it's been months since I coded for pure pleasure with short build times,
 // and it's been a reminder why I enjoy test-first development so much - refactoring without fear.
 // 
-// This supports the full m x n x k case but you have to tweak the code to do it: see shallWePlayAGame, line 242.
+// This supports the full m x n x k case: pass --rules WxHxK to tictactoeconsole (see parseRuleSet in batch.h.)
 // 
 // I think what I ended up with here has most of the good traits of an FP program (care with sources of truth,
 // not losing history of data) without the downsides (perf, space, risk of blowing out the stack.)
@@ -16,9 +17,11 @@
 // internal representation of the game state (see comment by turnForCell in tictactoe.h.)
 
 #include <assert.h>
+#include <string.h>
 
 #include <algorithm>
 
+#include "evaluator.h"
 #include "tictactoe.h"
 #include "userio.h"
 
@@ -31,6 +34,8 @@ namespace TicTacToe {
 
 	const Move UndoMove(0xffffffff, 0xffffffff);
 
+	const int LineDirections[4][2] = { { +1, 0 }, { 0, +1 }, { +1, +1 }, { +1, -1 } };
+
 	//
 	// RuleSet
 	//
@@ -42,12 +47,315 @@ namespace TicTacToe {
 	//
 	// MoveList
 	//
+	// turn numbers go from 0 to area - 1 and we need one more value for the empty sentinel
+	static uint8_t getCellBytes(const RuleSet& ruleSet)
+	{
+		const uint64_t area = (uint64_t)ruleSet.boardWidth * ruleSet.boardHeight;
+		return (area <= UINT8_MAX) ? 1 : (area <= UINT16_MAX) ? 2 : 4;
+	}
+
+	// worked out in 64 bits - a board near parseRuleSet's INT_MAX cells at 4 bytes a cell is well past 4GB
+	static size_t getTurnForCellBytes(const RuleSet& ruleSet)
+	{
+		const uint64_t bytes = (uint64_t)ruleSet.boardWidth * ruleSet.boardHeight * getCellBytes(ruleSet);
+		assert(bytes <= numeric_limits<size_t>::max());
+		return (size_t)bytes;
+	}
+
+	// -1 goes in as all bits set, which is the sentinel for each width. memcpy because the arena doesn't promise
+	// any alignment for a byte vector; the compiler turns it into a plain load/store.
+	template <typename Narrow>
+	static void storeNarrow(pmr::vector<uint8_t>& narrowValues, size_t index, int value)
+	{
+		const Narrow narrowValue = (Narrow)value;
+		memcpy(&narrowValues[index * sizeof(Narrow)], &narrowValue, sizeof(Narrow));
+	}
+
+	template <typename Narrow>
+	static int loadNarrow(const pmr::vector<uint8_t>& narrowValues, size_t index)
+	{
+		Narrow narrowValue;
+		memcpy(&narrowValue, &narrowValues[index * sizeof(Narrow)], sizeof(Narrow));
+		return (narrowValue == numeric_limits<Narrow>::max()) ? -1 : (int)narrowValue;
+	}
+
+	static void storeNarrow(pmr::vector<uint8_t>& narrowValues, uint8_t width, size_t index, int value)
+	{
+		switch (width)
+		{
+		case 1: storeNarrow<uint8_t>(narrowValues, index, value); break;
+		case 2: storeNarrow<uint16_t>(narrowValues, index, value); break;
+		default: storeNarrow<uint32_t>(narrowValues, index, value); break;
+		}
+	}
+
+	static int loadNarrow(const pmr::vector<uint8_t>& narrowValues, uint8_t width, size_t index)
+	{
+		switch (width)
+		{
+		case 1: return loadNarrow<uint8_t>(narrowValues, index);
+		case 2: return loadNarrow<uint16_t>(narrowValues, index);
+		default: return loadNarrow<uint32_t>(narrowValues, index);
+		}
+	}
+
+	// a pmr::vector copy goes through the allocator an element at a time - this is an order of magnitude faster
+	template <typename T>
+	static pmr::vector<T> copyVector(const pmr::vector<T>& from, pmr::memory_resource* memoryResource)
+	{
+		pmr::vector<T> to(from.size(), memoryResource);
+		if (!from.empty())
+			memcpy(to.data(), from.data(), from.size() * sizeof(T));
+		return to;
+	}
+
+	struct MoveList::SearchState
+	{
+		SearchState(const MoveList& moveList, pmr::memory_resource* memoryResource) :
+			cellBytes(moveList.cellBytes),
+			area(moveList.ruleSet.boardWidth * moveList.ruleSet.boardHeight),
+			cells(moveList.turnForCell.size(), memoryResource),
+			slotForCell(moveList.turnForCell.size(), memoryResource),
+			candidates(memoryResource),
+			candidateSlot(memoryResource),
+			stonesNearby(memoryResource)
+		{
+			rebuild(moveList);
+		}
+
+		SearchState(const SearchState& other, pmr::memory_resource* memoryResource) :
+			cellBytes(other.cellBytes),
+			area(other.area),
+			cells(copyVector(other.cells, memoryResource)),
+			slotForCell(copyVector(other.slotForCell, memoryResource)),
+			emptyCount(other.emptyCount),
+			candidateRadius(other.candidateRadius),
+			candidates(copyVector(other.candidates, memoryResource)),
+			candidateSlot(copyVector(other.candidateSlot, memoryResource)),
+			stonesNearby(copyVector(other.stonesNearby, memoryResource)),
+			candidateCount(other.candidateCount)
+		{
+			if (other.evaluator)
+				evaluator.emplace(other.evaluator.value(), memoryResource);
+		}
+
+		size_t getBytes() const
+		{
+			return sizeof(SearchState) + cells.capacity() + slotForCell.capacity()
+				+ candidates.capacity() + candidateSlot.capacity() + stonesNearby.capacity() * sizeof(uint16_t)
+				+ (evaluator ? evaluator->getBytes() - sizeof(PatternEvaluator) : 0);
+		}
+
+		int load(const pmr::vector<uint8_t>& narrowValues, size_t index) const { return loadNarrow(narrowValues, cellBytes, index); }
+		void store(pmr::vector<uint8_t>& narrowValues, size_t index, int value) { storeNarrow(narrowValues, cellBytes, index, value); }
+
+		// everything from scratch, from what's on the board - O(n), or O(n r^2) with candidates
+		void rebuild(const MoveList& moveList)
+		{
+			// the board knows which turn went where, so the order of play can be recovered too
+			emptyCount = 0;
+			for (uint32_t cellIndex = 0; cellIndex < area; cellIndex++)
+			{
+				const int cellTurn = moveList._getCell(cellIndex);
+				const uint32_t slot = (cellTurn == -1) ? emptyCount++ : area - 1 - cellTurn;
+				store(cells, slot, cellIndex);
+				store(slotForCell, cellIndex, slot);
+			}
+
+			if (candidateRadius > 0)
+			{
+				fill(stonesNearby.begin(), stonesNearby.end(), (uint16_t)0);
+				fill(candidateSlot.begin(), candidateSlot.end(), (uint8_t)0xff);
+				candidateCount = 0;
+				for (uint32_t cellIndex = emptyCount; cellIndex < area; cellIndex++)
+				{
+					forEachNearbyCell(moveList, load(cells, cellIndex), false, [this](uint32_t nearbyCell) { stonesNearby[nearbyCell]++; });
+				}
+				for (uint32_t slot = 0; slot < emptyCount; slot++)
+				{
+					const uint32_t cellIndex = load(cells, slot);
+					if (stonesNearby[cellIndex] > 0)
+						appendCandidate(cellIndex);
+				}
+			}
+
+			if (evaluator)
+				evaluator->recount(moveList);
+		}
+
+		void enableCandidates(const MoveList& moveList, int radius)
+		{
+			assert(radius > 0);
+			// the counts are uint16s
+			assert((2 * radius + 1) * (2 * radius + 1) <= UINT16_MAX);
+			candidateRadius = radius;
+			candidates.resize(cells.size());
+			candidateSlot.resize(cells.size());
+			stonesNearby.resize(area);
+			rebuild(moveList);
+		}
+
+		// every cell within candidateRadius of cellIndex, not counting itself; backwards visits them in the
+		// opposite order, which is what lets undo take back exactly what addMove did
+		template <typename Visit>
+		void forEachNearbyCell(const MoveList& moveList, uint32_t cellIndex, bool backwards, Visit visit) const
+		{
+			const int width = (int)moveList.ruleSet.boardWidth;
+			const int height = (int)moveList.ruleSet.boardHeight;
+			const int centerX = (int)(cellIndex % width);
+			const int centerY = (int)(cellIndex / width);
+			const int step = backwards ? -1 : +1;
+			const int first = backwards ? candidateRadius : -candidateRadius;
+			for (int dy = first; abs(dy) <= candidateRadius; dy += step)
+			{
+				for (int dx = first; abs(dx) <= candidateRadius; dx += step)
+				{
+					const int x = centerX + dx;
+					const int y = centerY + dy;
+					if ((dx != 0 || dy != 0) && x >= 0 && y >= 0 && x < width && y < height)
+						visit((uint32_t)(y * width + x));
+				}
+			}
+		}
+
+		void cellFilled(const MoveList& moveList, uint32_t cellIndex)
+		{
+			takeFromSet(cells, slotForCell, emptyCount, cellIndex);
+			if (candidateRadius > 0)
+			{
+				// it was empty, so it was a candidate if there was anything near it
+				if (stonesNearby[cellIndex] > 0)
+					takeFromSet(candidates, candidateSlot, candidateCount, cellIndex);
+				forEachNearbyCell(moveList, cellIndex, false, [&](uint32_t nearbyCell)
+				{
+					if (++stonesNearby[nearbyCell] == 1 && moveList._getCell(nearbyCell) == -1)
+						appendCandidate(nearbyCell);
+				});
+			}
+		}
+
+		// exactly undoes cellFilled, in reverse
+		void cellEmptied(const MoveList& moveList, uint32_t cellIndex)
+		{
+			if (candidateRadius > 0)
+			{
+				// If we saw this move played, its neighbours were appended in this order, so going backwards each
+				// one is the last candidate and this is just a pop. If it was played before enableCandidates they
+				// went in by rebuild, in board order, and have to be swapped out from wherever they are.
+				forEachNearbyCell(moveList, cellIndex, true, [&](uint32_t nearbyCell)
+				{
+					if (--stonesNearby[nearbyCell] == 0 && moveList._getCell(nearbyCell) == -1)
+						takeFromSet(candidates, candidateSlot, candidateCount, nearbyCell);
+				});
+				if (stonesNearby[cellIndex] > 0)
+					putBackInSet(candidates, candidateSlot, candidateCount, cellIndex);
+			}
+			putBackInSet(cells, slotForCell, emptyCount, cellIndex);
+		}
+
+		// Swaps cellIndex with the last member of the set and shrinks the set, so it lands just past the end.
+		// Its slot entry keeps pointing at where it was, so putBackInSet can undo this exactly.
+		void takeFromSet(pmr::vector<uint8_t>& set, pmr::vector<uint8_t>& slotFor, uint32_t& count, uint32_t cellIndex)
+		{
+			const int slot = load(slotFor, cellIndex);
+			const int lastCell = load(set, count - 1);
+			store(set, slot, lastCell);
+			store(slotFor, lastCell, slot);
+			store(set, count - 1, cellIndex);
+			store(slotFor, cellIndex, slot);
+			count--;
+		}
+
+		void putBackInSet(pmr::vector<uint8_t>& set, pmr::vector<uint8_t>& slotFor, uint32_t& count, uint32_t cellIndex)
+		{
+			const int slot = load(slotFor, cellIndex);
+			// no slot (or a stale one) means it was taken before we were keeping track, so no order to restore
+			if (slot < 0 || slot >= (int)count)
+			{
+				store(set, count, cellIndex);
+				store(slotFor, cellIndex, count);
+				count++;
+				return;
+			}
+			const int displacedCell = load(set, slot);
+			store(set, count, displacedCell);
+			store(slotFor, displacedCell, count);
+			store(set, slot, cellIndex);
+			count++;
+		}
+
+		void appendCandidate(uint32_t cellIndex)
+		{
+			store(candidates, candidateCount, cellIndex);
+			store(candidateSlot, cellIndex, candidateCount);
+			candidateCount++;
+		}
+
+		const uint8_t cellBytes;
+		const uint32_t area;
+
+		// Every cell, in cellBytes-wide indices: [0, emptyCount) are the empty squares, and the rest are the moves
+		// in reverse order of play - addMove swaps the cell it fills with the last empty one, so the move on turn t
+		// is always at area - 1 - t, which is what makes undo O(1). slotForCell is where each cell is in cells.
+		pmr::vector<uint8_t> cells;
+		pmr::vector<uint8_t> slotForCell;
+		uint32_t emptyCount = 0;
+
+		// the near-stones candidates, kept the same way; 0 means they're off
+		int candidateRadius = 0;
+		pmr::vector<uint8_t> candidates;
+		pmr::vector<uint8_t> candidateSlot;
+		// how many stones are within candidateRadius of each cell
+		pmr::vector<uint16_t> stonesNearby;
+		uint32_t candidateCount = 0;
+
+		optional<PatternEvaluator> evaluator;
+	};
+
 	MoveList::MoveList() :
-		turnForCell(ruleSet.boardWidth* ruleSet.boardHeight, -1) {}
+		MoveList(RuleSet()) {}
 
-	MoveList::MoveList(const RuleSet& _ruleSet) :
+	MoveList::MoveList(const RuleSet& _ruleSet, pmr::memory_resource* memoryResource) :
 		ruleSet(_ruleSet),
-		turnForCell(_ruleSet.boardWidth* _ruleSet.boardHeight, -1) {}
+		cellBytes(getCellBytes(_ruleSet)),
+		turnForCell(getTurnForCellBytes(_ruleSet), memoryResource)
+	{
+		reset();
+	}
+
+	MoveList::MoveList(const MoveList& other) :
+		MoveList(other, other.turnForCell.get_allocator().resource()) {}
+
+	MoveList::MoveList(const MoveList& other, pmr::memory_resource* memoryResource) :
+		ruleSet(other.ruleSet),
+		turn(other.turn),
+		takebacks(other.takebacks),
+		cellBytes(other.cellBytes),
+		turnForCell(copyVector(other.turnForCell, memoryResource))
+	{
+		if (other.searchState)
+		{
+			searchState = pmr::polymorphic_allocator<SearchState>(memoryResource).new_object<SearchState>(*other.searchState, memoryResource);
+		}
+	}
+
+	MoveList::~MoveList()
+	{
+		if (searchState)
+		{
+			pmr::polymorphic_allocator<SearchState>(turnForCell.get_allocator().resource()).delete_object(searchState);
+		}
+	}
+
+	MoveList::SearchState& MoveList::_getSearchState()
+	{
+		if (!searchState)
+		{
+			pmr::memory_resource* memoryResource = turnForCell.get_allocator().resource();
+			searchState = pmr::polymorphic_allocator<SearchState>(memoryResource).new_object<SearchState>(*this, memoryResource);
+		}
+		return *searchState;
+	}
 
 	// considered having addMove, getNthMove, etc be able to return errors but this is ergonomically less of a hassle
 	bool MoveList::isValid(Move move) const
@@ -64,29 +372,156 @@ namespace TicTacToe {
 	{
 		assert(isValid(move));
 		_setCell(move, turn++);
+		if (searchState)
+		{
+			searchState->cellFilled(*this, move.y * ruleSet.boardWidth + move.x);
+			if (searchState->evaluator)
+				searchState->evaluator->cellChanged(*this, move, -1);
+		}
 	}
 
 	void MoveList::undo() 
 	{
 		if (turn > 0)
 		{
+			// O(n) unless there's search state, which remembers which cell each turn went in
+			const Move move = getMoveForTurn(turn - 1);
 			turn--;
+			takebacks++;
+			_setCell(move, -1);
+			if (searchState)
+			{
+				searchState->cellEmptied(*this, move.y * ruleSet.boardWidth + move.x);
+				if (searchState->evaluator)
+					searchState->evaluator->cellChanged(*this, move, turn % 2);
+			}
+		}
+	}
+
+	Move MoveList::getMoveForTurn(int turnNumber) const
+	{
+		assert(turnNumber >= 0 && turnNumber < turn);
+		uint32_t cellIndex = 0;
+		if (searchState)
+		{
+			cellIndex = (uint32_t)searchState->load(searchState->cells, searchState->area - 1 - turnNumber);
+		}
+		else
+		{
+			while (_getCell(cellIndex) != turnNumber)
+			{
+				cellIndex++;
+			}
+		}
+		return Move(cellIndex % ruleSet.boardWidth, cellIndex / ruleSet.boardWidth);
+	}
+
+	void MoveList::reset()
+	{
+		turn = 0;
+		takebacks++;
+		// all bits set is the empty sentinel whatever the width
+		fill(turnForCell.begin(), turnForCell.end(), (uint8_t)0xff);
+		if (searchState)
+		{
+			searchState->rebuild(*this);
+		}
+	}
+
+	size_t MoveList::getBytesPerPosition() const
+	{
+		return sizeof(MoveList) + turnForCell.capacity() + (searchState ? searchState->getBytes() : 0);
+	}
 
-			// O(n), it could be O(k) if I store the last move instead of the last turn #
-			// this feels less likely to have bugs later though
-			replace(turnForCell.begin(), turnForCell.end(), turn, -1);
+	void MoveList::enableEvaluation()
+	{
+		SearchState& state = _getSearchState();
+		if (!state.evaluator)
+		{
+			state.evaluator.emplace(ruleSet, turnForCell.get_allocator().resource());
+			state.evaluator->recount(*this);
+		}
+	}
+
+	void MoveList::enableMoveGeneration()
+	{
+		_getSearchState();
+	}
+
+	void MoveList::enableCandidates(int radius)
+	{
+		SearchState& state = _getSearchState();
+		if (state.candidateRadius != radius)
+			state.enableCandidates(*this, radius);
+	}
+
+	CellRange MoveList::getEmptySquares() const
+	{
+		assert(searchState);
+		return CellRange(searchState->cells.data(), searchState->emptyCount, cellBytes, ruleSet.boardWidth);
+	}
+
+	CellRange MoveList::getCandidates() const
+	{
+		assert(searchState && searchState->candidateRadius > 0);
+		return CellRange(searchState->candidates.data(), searchState->candidateCount, cellBytes, ruleSet.boardWidth);
+	}
+
+	//
+	// CellRange
+	//
+	Move CellRange::operator[](size_t index) const
+	{
+		uint32_t cellIndex;
+		switch (cellBytes)
+		{
+		case 1:
+			cellIndex = cells[index];
+			break;
+		case 2:
+		{
+			uint16_t narrowCellIndex;
+			memcpy(&narrowCellIndex, cells + index * 2, sizeof(narrowCellIndex));
+			cellIndex = narrowCellIndex;
+			break;
 		}
+		default:
+			memcpy(&cellIndex, cells + index * 4, sizeof(cellIndex));
+			break;
+		}
+		return Move(cellIndex % boardWidth, cellIndex / boardWidth);
+	}
+
+	const PatternEvaluator* MoveList::getEvaluator() const
+	{
+		return (searchState && searchState->evaluator) ? &searchState->evaluator.value() : nullptr;
+	}
+
+	int64_t MoveList::getEvaluation() const
+	{
+		assert(getEvaluator());
+		return searchState->evaluator->getScore();
 	}
 
 	void MoveList::_setCell(Move move, int turn)
 	{
 		// on which turn was an x or o placed in that cell
-		turnForCell[move.y * ruleSet.boardWidth + move.x] = turn;
+		_setCell(move.y * ruleSet.boardWidth + move.x, turn);
 	}
 
 	int MoveList::_getCell(Move move) const
 	{
-		return turnForCell[move.y * ruleSet.boardWidth + move.x];
+		return _getCell(move.y * ruleSet.boardWidth + move.x);
+	}
+
+	void MoveList::_setCell(size_t cellIndex, int turn)
+	{
+		storeNarrow(turnForCell, cellBytes, cellIndex, turn);
+	}
+
+	int MoveList::_getCell(size_t cellIndex) const
+	{
+		return loadNarrow(turnForCell, cellBytes, cellIndex);
 	}
 
 	int MoveList::whoseTurn() const {
@@ -153,6 +588,17 @@ namespace TicTacToe {
 	// sweepDX/DY is how it then sweeps
 	// for example 0,0 - 0,1 and 1,0 will go from left to right, sweeping downward, checking for adjacent Xs/Os in that column
 	optional<int> MoveList::searchForWinner(int startX, int startY, int startingDX, int startingDY, int sweepDX, int sweepDY, int count) const
+	{
+		switch (cellBytes)
+		{
+		case 1: return searchForWinnerIn<uint8_t>(startX, startY, startingDX, startingDY, sweepDX, sweepDY, count);
+		case 2: return searchForWinnerIn<uint16_t>(startX, startY, startingDX, startingDY, sweepDX, sweepDY, count);
+		default: return searchForWinnerIn<uint32_t>(startX, startY, startingDX, startingDY, sweepDX, sweepDY, count);
+		}
+	}
+
+	template <typename NarrowTurn>
+	optional<int> MoveList::searchForWinnerIn(int startX, int startY, int startingDX, int startingDY, int sweepDX, int sweepDY, int count) const
 	{
 		// mostly these asserts are for documentation purposes
 		assert(abs(startingDX) <= 1);
@@ -180,7 +626,7 @@ namespace TicTacToe {
 			for (; (sweepDY == 0) ? (lineCheckerX < (int)ruleSet.boardWidth) : (lineCheckerY < (int)ruleSet.boardHeight);)
 			{
 				int xOrO = (lineCheckerX >= 0 && lineCheckerX < (int)ruleSet.boardWidth) ?
-					turnForCell[lineCheckerY * ruleSet.boardWidth + lineCheckerX] % 2 : // conveniently, -1 % 2 is -1 so it does what we want for the 'empty' case
+					loadNarrow<NarrowTurn>(turnForCell, lineCheckerY * ruleSet.boardWidth + lineCheckerX) % 2 : // conveniently, -1 % 2 is -1 so it does what we want for the 'empty' case
 					-1;
 				if (lastXorO == xOrO)
 				{
@@ -235,12 +681,12 @@ namespace TicTacToe {
 		return (count == 2) ? optional(Move(input1, input2)) : nullopt;
 	}
 
-	void shallWePlayAGame(weak_ptr<IUserIO> userIO)
+	void shallWePlayAGame(weak_ptr<IUserIO> userIO, const RuleSet& ruleSet)
 	{
 		auto lockedUserIO = userIO.lock();
 		assert(lockedUserIO);  // if it's already invalid that's wack
 		lockedUserIO->print("Shall we play a game?\n");
-		MoveList initialMoveList(RuleSet(3, 3, 3));
+		MoveList initialMoveList(ruleSet);
 		takeTurns(initialMoveList, userIO);
 	}
 
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <utility>
 #include <vector>
@@ -9,6 +10,8 @@
 class IUserIO;
 
 namespace TicTacToe {
+	class PatternEvaluator;
+
 	struct Move 
 	{
 		uint32_t x;
@@ -18,6 +21,9 @@ namespace TicTacToe {
 		bool operator==(Move m2) const { return x == m2.x && y == m2.y; }
 	};
 
+	// what parseCommand returns for "undo"
+	extern const Move UndoMove;
+
 	struct RuleSet 
 	{
 		uint32_t boardWidth = 3;
@@ -29,11 +35,81 @@ namespace TicTacToe {
 		bool isInBounds(Move move) const;
 	};
 
+	// right, down, down-right, up-right - between them and their opposites that's every line through a cell
+	extern const int LineDirections[4][2];
+
+	// Whether the stone at move is part of a run of nInARow or more, for any kind of board: xOrOAt(Move) gives
+	// -1/0/1 and only gets asked about cells in bounds. Only looks along the lines through move, so it's how
+	// anything that keeps a winner up to date one stone at a time checks the new stone.
+	template <typename XorOAt>
+	bool isInWinningRun(const RuleSet& ruleSet, Move move, XorOAt xOrOAt)
+	{
+		const int xOrO = xOrOAt(move);
+		for (const auto& direction : LineDirections)
+		{
+			int runLength = 1;
+			for (int sign : { -1, +1 })
+			{
+				Move runMove(move.x + sign * direction[0], move.y + sign * direction[1]);
+				// going off the left or top wraps round to huge, which isInBounds catches
+				while (ruleSet.isInBounds(runMove) && xOrOAt(runMove) == xOrO)
+				{
+					runLength++;
+					runMove = Move(runMove.x + sign * direction[0], runMove.y + sign * direction[1]);
+				}
+			}
+			if (runLength >= ruleSet.nInARow)
+				return true;
+		}
+		return false;
+	}
+
+	// A view of one of the lists of cells MoveList keeps for move generation - iterating it gives you Moves.
+	// Good until the MoveList goes away; see MoveList::getEmptySquares for what addMove/undo do to it.
+	class CellRange
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(const CellRange* _range, size_t _index) : range(_range), index(_index) {}
+			Move operator*() const { return (*range)[index]; }
+			Iterator& operator++() { index++; return *this; }
+			bool operator!=(const Iterator& other) const { return index != other.index; }
+
+		private:
+			const CellRange* range;
+			size_t index;
+		};
+
+		CellRange(const uint8_t* _cells, size_t _count, uint8_t _cellBytes, uint32_t _boardWidth) :
+			cells(_cells), count(_count), cellBytes(_cellBytes), boardWidth(_boardWidth) {}
+
+		Iterator begin() const { return Iterator(this, 0); }
+		Iterator end() const { return Iterator(this, count); }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		Move operator[](size_t index) const;
+
+	private:
+		// cell indices (y * width + x), cellBytes wide like everything else in MoveList
+		const uint8_t* cells;
+		size_t count;
+		uint8_t cellBytes;
+		uint32_t boardWidth;
+	};
+
 	class MoveList 
 	{
 	public:
 		MoveList();
-		MoveList(const RuleSet& _ruleSet);
+		// Pass a memory resource (a std::pmr::monotonic_buffer_resource over a stack buffer, an unsynchronized_pool_resource
+		// per search thread, ...) if you're going to hold a lot of these - copies share the resource of the MoveList they
+		// were copied from, and reset() never allocates, so a board pulled from a pool never touches the global heap again.
+		MoveList(const RuleSet& _ruleSet, std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+		MoveList(const MoveList& other);
+		MoveList(const MoveList& other, std::pmr::memory_resource* memoryResource);
+		~MoveList();
 
 		// -1 for nothing, 0 for X, 1 for O 
 		int getXorO(Move move) const;
@@ -43,6 +119,11 @@ namespace TicTacToe {
 
 		void addMove(Move move);
 		void undo();
+		// turns start at 0, and it has to be a turn that's been played and not undone.
+		// O(1) once move generation is on (see enableMoveGeneration), O(n) before that.
+		Move getMoveForTurn(int turnNumber) const;
+		// back to an empty board, keeping the storage
+		void reset();
 
 		bool isBoardFull() const;
 
@@ -50,29 +131,74 @@ namespace TicTacToe {
 
 		int whoseTurn() const;
 		int getTurn() const { return turn; }
+		// Goes up whenever undo or reset takes a move away. While it stays put, every move that was on the board
+		// before is still there on the same turn, so anyone following along only has to look at the new turns.
+		uint32_t getTakebacks() const { return takebacks; }
 
 		const RuleSet ruleSet;
 		std::optional<int> getOverallWin() const;
 
+		// everything it takes to hold this position in memory, including the cells on the heap (or in the arena)
+		size_t getBytesPerPosition() const;
+
+		// Move generation for bots and search, so they don't have to scan the whole board at every node. Once it's
+		// on (enableEvaluation turns it on too) addMove/undo keep the empty squares up to date in O(1).
+		void enableMoveGeneration();
+		bool isMoveGenerationEnabled() const { return searchState != nullptr; }
+		// The "near stones" candidates for big boards: the empty squares within radius (diagonals included) of any
+		// stone, kept up to date in O(radius^2) per move. Empty on an empty board, so have an opening move in mind.
+		void enableCandidates(int radius);
+		// Move generation has to be on. undo puts these back in exactly the order they were in before the addMove,
+		// so it's fine to walk one while you addMove/undo inside the loop - the way search does. (Undoing a move
+		// from before enableCandidates keeps the set right but not its order, since there's no order to go back to.)
+		CellRange getEmptySquares() const;
+		CellRange getCandidates() const;
+
+		// Static evaluation for depth-limited search on big boards. Off by default since plain games don't need it;
+		// once it's on, addMove/undo keep it up to date by only looking at the lines through the cell that changed.
+		void enableEvaluation();
+		bool isEvaluationEnabled() const { return getEvaluator() != nullptr; }
+		// O(1) - positive is good for player 0, negative for player 1. Evaluation must be enabled.
+		int64_t getEvaluation() const;
+		// nullptr unless evaluation is enabled
+		const PatternEvaluator* getEvaluator() const;
+
 	private:
 		std::optional<int> getRowWin() const;
 		std::optional<int> getColumnWin() const;
 		std::optional<int> getSEDiagonalWin() const;
 		std::optional<int> getSWDiagonalWin() const;
 		std::optional<int> searchForWinner(int startX, int startY, int startingDX, int startingDY, int sweepDX, int sweepDY, int count) const;
+		// searchForWinner picks the cell width once rather than for every cell it visits
+		template <typename NarrowTurn>
+		std::optional<int> searchForWinnerIn(int startX, int startY, int startingDX, int startingDY, int sweepDX, int sweepDY, int count) const;
 
 		void _setCell(Move move, int turn);
 		int _getCell(Move move) const;
+		void _setCell(size_t cellIndex, int turn);
+		int _getCell(size_t cellIndex) const;
 
 		// This is duplication of data-two sources of the same truth-since we could find the current turn by taking max()
 		// of the board and add 1... but y'all asked me to optimize so doing it this way
 		int turn = 0;
+		uint32_t takebacks = 0;
 
 		// This insight didn't come to me right away but implementing it almost as if it was a newspaper article on
 		// a Go game, where each square contains the turn its piece was played (or -1 for empty), and X and O
 		// can be determined by the modulo 2 of the turn - keeps the history of the moves compact for undo/replay
 		// purposes, doesn't lose data (until you undo), and is amenable to searching for wins in O(n) time.
-		std::vector<int> turnForCell;
+		// The turn numbers are stored in the narrowest unsigned type that fits the board - 1 byte per cell for
+		// anything up to 15x15, 2 up to 255x255 - with all bits set standing in for the -1 of an empty square.
+		// _getCell/_setCell hide that so the rest of the class still sees plain ints.
+		uint8_t cellBytes;
+		std::pmr::vector<uint8_t> turnForCell;
+
+		// Everything search wants on top of the bare board (move generation, the evaluator) lives behind
+		// this pointer so plain positions stay small. Null until something like enableEvaluation asks for it;
+		// allocated from the same memory resource as the cells.
+		struct SearchState;
+		SearchState* searchState = nullptr;
+		SearchState& _getSearchState();
 
 	};
 
@@ -90,7 +216,7 @@ namespace TicTacToe {
 	// (even a raw pointer would be safe) if this was the real world we might have to deal with
 	// some weird suspend/resume or teardown situations with multiple threads and would want
 	// to handle it gracefully, thus the weak_ptr.
-	void shallWePlayAGame(std::weak_ptr<IUserIO> userIO);
+	void shallWePlayAGame(std::weak_ptr<IUserIO> userIO, const RuleSet& ruleSet = RuleSet(3, 3, 3));
 	// Though I think now it would be better to use a unique_ptr that we return when we're done,
 	// like borrowing in Rust - though then there'd be the ergonomic hassle of takeTurn (below) having two things to return.
 
@@ -0,0 +1,188 @@
+#include <assert.h>
+
+#include <algorithm>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+#include "threadpool.h"
+#include "tournament.h"
+#include "userio.h"
+
+using namespace std;
+
+
+namespace TicTacToe {
+
+	static bool openingFits(const RuleSet& ruleSet, const vector<Move>& opening)
+	{
+		MoveList moveList(ruleSet);
+		for (Move move : opening)
+		{
+			if (!moveList.isValid(move) || moveList.getOverallWin())
+				return false;
+			moveList.addMove(move);
+		}
+		return !moveList.getOverallWin() && !moveList.isBoardFull();
+	}
+
+	TournamentGame playEngineGame(const RuleSet& ruleSet, const vector<Move>& opening, IPlayer& player0, IPlayer& player1)
+	{
+		TournamentGame game;
+		MoveList moveList(ruleSet);
+		for (Move move : opening)
+		{
+			moveList.addMove(move);
+			game.moves.push_back(move);
+		}
+
+		IPlayer* players[2] = { &player0, &player1 };
+		while (!game.winner && !moveList.isBoardFull())
+		{
+			const Move move = players[moveList.whoseTurn()]->chooseMove(moveList);
+			assert(moveList.isValid(move));
+			moveList.addMove(move);
+			game.moves.push_back(move);
+			game.winner = moveList.getOverallWin();
+		}
+		return game;
+	}
+
+	TournamentResult runTournament(const TournamentSettings& settings)
+	{
+		const vector<vector<Move>> noOpenings(1);
+		const vector<vector<Move>>& openings = settings.openings.empty() ? noOpenings : settings.openings;
+
+		// lay out the whole schedule first; each game's slot is its own so the workers never share anything
+		// but the pool
+		TournamentResult result;
+		for (size_t ruleSetIndex = 0; ruleSetIndex < settings.ruleSets.size(); ruleSetIndex++)
+		{
+			for (const vector<Move>& opening : openings)
+			{
+				if (!openingFits(settings.ruleSets[ruleSetIndex], opening))
+					continue;
+				for (size_t engine0 = 0; engine0 < settings.engines.size(); engine0++)
+				{
+					for (size_t engine1 = 0; engine1 < settings.engines.size(); engine1++)
+					{
+						if (engine0 == engine1)
+							continue;
+						for (int repeat = 0; repeat < settings.gamesPerOpening; repeat++)
+						{
+							TournamentGame game;
+							game.ruleSetIndex = ruleSetIndex;
+							game.engineIndex[0] = engine0;
+							game.engineIndex[1] = engine1;
+							game.moves = opening;
+							result.games.push_back(move(game));
+						}
+					}
+				}
+			}
+		}
+
+		const auto startTime = chrono::steady_clock::now();
+		{
+			WorkStealingPool pool(settings.threads);
+			for (size_t gameIndex = 0; gameIndex < result.games.size(); gameIndex++)
+			{
+				pool.submit([&settings, &result, gameIndex]
+				{
+					TournamentGame& game = result.games[gameIndex];
+					const uint32_t seed = settings.seed + (uint32_t)gameIndex * 2;
+					unique_ptr<IPlayer> player0 = settings.engines[game.engineIndex[0]].factory(seed);
+					unique_ptr<IPlayer> player1 = settings.engines[game.engineIndex[1]].factory(seed + 1);
+					const TournamentGame playedGame = playEngineGame(settings.ruleSets[game.ruleSetIndex], game.moves, *player0, *player1);
+					game.moves = playedGame.moves;
+					game.winner = playedGame.winner;
+				});
+			}
+			pool.wait();
+		}
+		result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+		result.engineStats.resize(settings.engines.size());
+		for (const TournamentGame& game : result.games)
+		{
+			if (game.winner)
+			{
+				result.engineStats[game.engineIndex[game.winner.value()]].wins++;
+				result.engineStats[game.engineIndex[1 - game.winner.value()]].losses++;
+			}
+			else
+			{
+				result.engineStats[game.engineIndex[0]].draws++;
+				result.engineStats[game.engineIndex[1]].draws++;
+			}
+		}
+		return result;
+	}
+
+	optional<vector<vector<Move>>> readOpenings(istream& openingsFile)
+	{
+		vector<vector<Move>> openings;
+		string line;
+		while (getline(openingsFile, line))
+		{
+			istringstream commands(line);
+			string command;
+			vector<Move> opening;
+			while (commands >> command)
+			{
+				if (opening.empty() && command[0] == '#')
+					break;
+				const optional<Move> move = parseCommand(command);
+				if (!move || move == UndoMove)
+					return nullopt;
+				opening.push_back(move.value());
+			}
+			if (!opening.empty())
+				openings.push_back(opening);
+		}
+		return openings;
+	}
+
+	void writeArchive(ostream& archive, const TournamentSettings& settings, const TournamentResult& result)
+	{
+		optional<size_t> lastRuleSetIndex;
+		for (const TournamentGame& game : result.games)
+		{
+			if (lastRuleSetIndex != game.ruleSetIndex)
+			{
+				const RuleSet& ruleSet = settings.ruleSets[game.ruleSetIndex];
+				archive << "# rules " << ruleSet.boardWidth << "x" << ruleSet.boardHeight << "x" << ruleSet.nInARow << "\n";
+				lastRuleSetIndex = game.ruleSetIndex;
+			}
+			archive << "# " << settings.engines[game.engineIndex[0]].name << " vs " << settings.engines[game.engineIndex[1]].name << ": "
+				<< (game.winner ? "Player " + to_string(game.winner.value()) + " wins" : string("Nobody wins")) << "\n";
+			for (size_t moveIndex = 0; moveIndex < game.moves.size(); moveIndex++)
+			{
+				archive << (moveIndex ? " " : "") << game.moves[moveIndex].x << "," << game.moves[moveIndex].y;
+			}
+			archive << "\n";
+		}
+	}
+
+	void printTournamentResult(const TournamentSettings& settings, const TournamentResult& result, weak_ptr<IUserIO> userIO)
+	{
+		auto lockedUserIO = userIO.lock();
+		assert(lockedUserIO);
+
+		char line[160];
+		snprintf(line, sizeof(line), "%zu games in %.3f s on %u threads - %.1f games/s\n", result.games.size(), result.seconds,
+			max(settings.threads, 1u), result.seconds > 0.0 ? result.games.size() / result.seconds : 0.0);
+		lockedUserIO->print(line);
+		lockedUserIO->print("engine            wins   draws  losses   score\n");
+		for (size_t engineIndex = 0; engineIndex < settings.engines.size(); engineIndex++)
+		{
+			const EngineStats& stats = result.engineStats[engineIndex];
+			const int games = stats.wins + stats.draws + stats.losses;
+			snprintf(line, sizeof(line), "%-16s %6d  %6d  %6d  %5.1f%%\n", settings.engines[engineIndex].name.c_str(),
+				stats.wins, stats.draws, stats.losses, games ? 100.0 * (stats.wins + 0.5 * stats.draws) / games : 0.0);
+			lockedUserIO->print(line);
+		}
+	}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "players.h"
+#include "tictactoe.h"
+
+class IUserIO;
+
+namespace TicTacToe {
+
+	// Engine-vs-engine games in bulk, for comparing engines and settings. Every engine plays every other engine
+	// with both colors, from every opening, on every RuleSet, spread over a WorkStealingPool.
+
+	struct TournamentEngine
+	{
+		std::string name;
+		PlayerFactory factory;
+	};
+
+	struct TournamentSettings
+	{
+		std::vector<RuleSet> ruleSets;
+		std::vector<TournamentEngine> engines;
+		// moves played before the engines take over; an opening that doesn't fit a RuleSet (off the board, or
+		// already over) is skipped for that RuleSet. No openings means every game starts on an empty board.
+		std::vector<std::vector<Move>> openings;
+		// how many times each pairing plays each opening with each color - only interesting if the engines
+		// use their seeds
+		int gamesPerOpening = 1;
+		unsigned threads = std::thread::hardware_concurrency();
+		uint32_t seed = 1;
+	};
+
+	struct TournamentGame
+	{
+		size_t ruleSetIndex = 0;
+		// indices into TournamentSettings::engines; engineIndex[0] played X
+		size_t engineIndex[2] = { 0, 0 };
+		// opening included
+		std::vector<Move> moves;
+		std::optional<int> winner;
+	};
+
+	struct EngineStats
+	{
+		int wins = 0;
+		int draws = 0;
+		int losses = 0;
+	};
+
+	struct TournamentResult
+	{
+		// in the order they were scheduled, whatever order they finished in, so archives are reproducible
+		std::vector<TournamentGame> games;
+		// same order as TournamentSettings::engines
+		std::vector<EngineStats> engineStats;
+		double seconds = 0.0;
+	};
+
+	TournamentResult runTournament(const TournamentSettings& settings);
+
+	// one opening per line, moves separated by whitespace like a batch script ("7,7 7,8"); '#' lines are skipped.
+	// Returns nothing if a line has something that isn't a move in it.
+	std::optional<std::vector<std::vector<Move>>> readOpenings(std::istream& openingsFile);
+
+	// plays one game out from the opening; the opening has to fit the rules
+	TournamentGame playEngineGame(const RuleSet& ruleSet, const std::vector<Move>& opening, IPlayer& player0, IPlayer& player1);
+
+	// The archive is a batch script (see batch.h) - one game per line, preceded by a comment naming the engines and
+	// the result, with a "# rules WxHxK" line whenever the rules change - so tictactoeconsole --batch replays it.
+	void writeArchive(std::ostream& archive, const TournamentSettings& settings, const TournamentResult& result);
+
+	// games/s and each engine's wins, draws and losses
+	void printTournamentResult(const TournamentSettings& settings, const TournamentResult& result, std::weak_ptr<IUserIO> userIO);
+
+}
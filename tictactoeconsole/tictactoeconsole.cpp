@@ -1,15 +1,250 @@
 // tictactoeconsole.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
+// tictactoeconsole [--rules WxHxK]... [--computer depth [--ponder]] [--batch [scriptfile]] [--bench name]
+//                  [--tournament engine,engine... [--games n] [--threads n] [--openings file] [--archive file]]
+//   --rules       board width, height and how many in a row to win; defaults to 3x3x3. Tournaments play every
+//                 --rules given, everything else uses the first.
+//   --computer    play against the computer (you're X), searching this many moves ahead
+//     --ponder    and let it think while you do
+//   --batch       headless: plays one scripted game per line from scriptfile (or stdin) and prints only the results
+//   --bench       runs a benchmark: memory, evaluation, spectator, branching, pondering
+//   --tournament  every engine (random, search1, search2, ...) plays every other with both colors
+//     --games     games per pairing per opening per color (default 1)
+//     --threads   worker threads (default one per core)
+//     --openings  one opening per line, like "7,7 7,8"
+//     --archive   write every game there in the --batch format
+//
 
 #include <stdio.h>  // not sure if y'all meant by "use standard input output" "use stdin/stdout, iostream is ok" or "use stdio"
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <vector>
 
+#include "../tictactoe/batch.h"
+#include "../tictactoe/benchmark.h"
+#include "../tictactoe/ponder.h"
 #include "../tictactoe/tictactoe.h"
+#include "../tictactoe/tournament.h"
 #include "../tictactoe/userio.h"
 
-int main()
+// the whole of text has to be a number bigger than 0 - atoi would quietly turn "abc" into 0
+static std::optional<int> parsePositive(const char* text)
 {
-    printf("Hello Psyonix.\n");
-    auto userIO = std::make_shared<UserIOStd>();
-    TicTacToe::shallWePlayAGame(userIO);
+    int value = 0;
+    int charsRead = 0;
+    if (sscanf_s(text, "%d%n", &value, &charsRead) != 1 || text[charsRead] != '\0' || value < 1)
+        return std::nullopt;
+    return value;
+}
+
+static int playTournament(TicTacToe::TournamentSettings& settings, const char* engineNames, const char* openingsFileName,
+    const char* archiveFileName, std::shared_ptr<IUserIO> userIO)
+{
+    std::istringstream engineList(engineNames);
+    std::string engineName;
+    while (std::getline(engineList, engineName, ','))
+    {
+        auto factory = TicTacToe::makePlayerFactory(engineName);
+        if (!factory)
+        {
+            printf("I don't know the engine '%s' - try random or search1, search2, ...\n", engineName.c_str());
+            return 1;
+        }
+        settings.engines.push_back({ engineName, factory.value() });
+    }
+    if (settings.engines.size() < 2)
+    {
+        printf("A tournament needs at least two engines.\n");
+        return 1;
+    }
+
+    if (openingsFileName)
+    {
+        std::ifstream openingsFile(openingsFileName);
+        auto openings = openingsFile ? TicTacToe::readOpenings(openingsFile) : std::nullopt;
+        if (!openings)
+        {
+            printf("Couldn't read openings from '%s'.\n", openingsFileName);
+            return 1;
+        }
+        settings.openings = openings.value();
+    }
+
+    const TicTacToe::TournamentResult result = TicTacToe::runTournament(settings);
+    TicTacToe::printTournamentResult(settings, result, userIO);
+
+    if (archiveFileName)
+    {
+        std::ofstream archiveFile(archiveFileName);
+        if (!archiveFile)
+        {
+            printf("Couldn't write '%s'.\n", archiveFileName);
+            return 1;
+        }
+        TicTacToe::writeArchive(archiveFile, settings, result);
+    }
+    return 0;
 }
 
+int main(int argc, char* argv[])
+{
+    std::vector<TicTacToe::RuleSet> ruleSets;
+    bool batch = false;
+    const char* scriptFileName = nullptr;
+    const char* benchmarkName = nullptr;
+    const char* engineNames = nullptr;
+    const char* openingsFileName = nullptr;
+    const char* archiveFileName = nullptr;
+    int computerDepth = 0;
+    bool pondering = false;
+    TicTacToe::TournamentSettings tournamentSettings;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--rules") == 0 && arg + 1 < argc)
+        {
+            const auto parsedRuleSet = TicTacToe::parseRuleSet(argv[++arg]);
+            if (!parsedRuleSet)
+            {
+                printf("I don't understand the rules '%s' - try something like 3x3x3 or 15x15x5.\n", argv[arg]);
+                return 1;
+            }
+            ruleSets.push_back(parsedRuleSet.value());
+        }
+        else if (strcmp(argv[arg], "--computer") == 0 && arg + 1 < argc)
+        {
+            const auto depth = parsePositive(argv[++arg]);
+            if (!depth)
+            {
+                printf("--computer needs how many moves ahead to look, at least 1 - not '%s'.\n", argv[arg]);
+                return 1;
+            }
+            computerDepth = depth.value();
+        }
+        else if (strcmp(argv[arg], "--ponder") == 0)
+        {
+            pondering = true;
+        }
+        else if (strcmp(argv[arg], "--batch") == 0)
+        {
+            batch = true;
+            if (arg + 1 < argc && strncmp(argv[arg + 1], "--", 2) != 0)
+                scriptFileName = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--bench") == 0 && arg + 1 < argc)
+        {
+            benchmarkName = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--tournament") == 0 && arg + 1 < argc)
+        {
+            engineNames = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--games") == 0 && arg + 1 < argc)
+        {
+            const auto games = parsePositive(argv[++arg]);
+            if (!games)
+            {
+                printf("--games needs a number of games, at least 1 - not '%s'.\n", argv[arg]);
+                return 1;
+            }
+            tournamentSettings.gamesPerOpening = games.value();
+        }
+        else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+        {
+            const auto threads = parsePositive(argv[++arg]);
+            if (!threads)
+            {
+                printf("--threads needs a number of threads, at least 1 - not '%s'.\n", argv[arg]);
+                return 1;
+            }
+            tournamentSettings.threads = (unsigned)threads.value();
+        }
+        else if (strcmp(argv[arg], "--openings") == 0 && arg + 1 < argc)
+        {
+            openingsFileName = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--archive") == 0 && arg + 1 < argc)
+        {
+            archiveFileName = argv[++arg];
+        }
+        else
+        {
+            printf("usage: tictactoeconsole [--rules WxHxK]... [--computer depth [--ponder]] [--batch [scriptfile]] [--bench name]\n"
+                "                        [--tournament engine,engine... [--games n] [--threads n] [--openings file] [--archive file]]\n");
+            return 1;
+        }
+    }
+    if (ruleSets.empty())
+    {
+        ruleSets.push_back(TicTacToe::RuleSet(3, 3, 3));
+    }
+    const TicTacToe::RuleSet& ruleSet = ruleSets[0];
+
+    auto userIO = std::make_shared<UserIOStd>();
+    if (engineNames)
+    {
+        tournamentSettings.ruleSets = ruleSets;
+        return playTournament(tournamentSettings, engineNames, openingsFileName, archiveFileName, userIO);
+    }
+    if (benchmarkName)
+    {
+        if (strcmp(benchmarkName, "memory") == 0)
+        {
+            TicTacToe::benchmarkMemory(userIO);
+        }
+        else if (strcmp(benchmarkName, "evaluation") == 0)
+        {
+            TicTacToe::benchmarkEvaluation(userIO);
+        }
+        else if (strcmp(benchmarkName, "spectator") == 0)
+        {
+            TicTacToe::benchmarkSpectator(userIO);
+        }
+        else if (strcmp(benchmarkName, "branching") == 0)
+        {
+            TicTacToe::benchmarkBranching(userIO);
+        }
+        else if (strcmp(benchmarkName, "pondering") == 0)
+        {
+            TicTacToe::benchmarkPondering(userIO);
+        }
+        else
+        {
+            printf("I don't know the benchmark '%s'.\n", benchmarkName);
+            return 1;
+        }
+        return 0;
+    }
+    if (batch)
+    {
+        if (scriptFileName)
+        {
+            std::ifstream scriptFile(scriptFileName);
+            if (!scriptFile)
+            {
+                printf("Couldn't open '%s'.\n", scriptFileName);
+                return 1;
+            }
+            TicTacToe::playBatch(scriptFile, ruleSet, userIO);
+        }
+        else
+        {
+            TicTacToe::playBatch(std::cin, ruleSet, userIO);
+        }
+        return 0;
+    }
+
+    printf("Hello Psyonix.\n");
+    if (computerDepth > 0)
+    {
+        userIO->print("Shall we play a game? You're X.\n");
+        TicTacToe::MoveList moveList(ruleSet);
+        TicTacToe::playAgainstComputer(moveList, userIO, computerDepth, pondering);
+        return 0;
+    }
+    TicTacToe::shallWePlayAGame(userIO, ruleSet);
+}